@@ -0,0 +1,322 @@
+/*
+    Benchmarks of the library's hot paths, written as JSON for regression tracking.
+
+    Usage: benchmark [--quick] [--threads 1,2,4] [--filter name] [--output file]
+
+        --quick     smaller sizes and shorter runs, for smoke testing
+        --threads   the thread counts to sweep over (see SetThreadCount).
+                    Default: powers of 2 up to std::thread::hardware_concurrency
+        --filter    only run benchmarks whose name contains this string
+        --output    the file to write the JSON to. Default: benchmark.json
+
+    Every benchmark runs once to warm up, then repeatedly until it has run for a minimum time.
+    Each result records the minimum, median and mean time per run in nanoseconds.
+    When built with POLY_INSTRUMENTATION, it also records the non-zero counters per run.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BinaryHeap.h"
+#include "Instrumentation.h"
+#include "PolyValGenerator.h"
+#include "Polynomial.h"
+#include "Util.h"
+
+struct Result {
+    std::string name;
+    uint64_t size;
+    size_t threads;
+    size_t iterations;
+    double min_ns;
+    double median_ns;
+    double mean_ns;
+    std::vector<std::pair<const char *, uint64_t>> counters;
+};
+
+struct Options {
+    bool quick = false;
+    std::vector<size_t> threads;
+    std::string filter;
+    std::string output = "benchmark.json";
+};
+
+/* Results are folded in here so the compiler cannot drop the work being timed */
+static volatile double sink;
+
+static std::mt19937_64 rng(12345);
+
+/* Random integer coefficients in [-10, 10], as recommended for Polynomial */
+static std::vector<double> RandomCoeffs(size_t n) {
+    std::uniform_int_distribution<int> d(-10, 10);
+    std::vector<double> c(n);
+    for (double &x : c) {
+        x = d(rng);
+    }
+    return c;
+}
+
+/* 1 + small terms, so the series inverse neither overflows nor underflows */
+static std::vector<double> UnitCoeffs(size_t n) {
+    std::uniform_real_distribution<double> d(-1, 1);
+    std::vector<double> c(n);
+    for (double &x : c) {
+        x = d(rng) / n;
+    }
+    c[0] = 1;
+    return c;
+}
+
+static Result Measure(const std::string &name, uint64_t size, double min_seconds,
+                      const std::function<void()> &f) {
+    using clock = std::chrono::steady_clock;
+    Instrumentation::Reset();
+    f();
+
+    std::vector<double> times;
+    double total = 0;
+    while (times.size() < 3 || (total < min_seconds * 1e9 && times.size() < 1000)) {
+        auto t1 = clock::now();
+        f();
+        auto t2 = clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t2 - t1).count();
+        times.push_back(ns);
+        total += ns;
+    }
+
+    std::sort(times.begin(), times.end());
+    Result r;
+    r.name = name;
+    r.size = size;
+    r.threads = GetThreadCount();
+    r.iterations = times.size();
+    r.min_ns = times.front();
+    r.median_ns = times[times.size() / 2];
+    r.mean_ns = total / times.size();
+
+    // Per run, including the warm-up
+    Instrumentation::Snapshot s = Instrumentation::Take();
+    for (int c = 0; c < Instrumentation::NUM_COUNTERS; c++) {
+        uint64_t v = s.counters[c] / (times.size() + 1);
+        if (v != 0) {
+            r.counters.emplace_back(Instrumentation::Name(static_cast<Instrumentation::Counter>(c)), v);
+        }
+    }
+    std::cerr << name << " size=" << size << " threads=" << r.threads
+              << " median=" << r.median_ns / 1e6 << "ms" << std::endl;
+    return r;
+}
+
+static void RunAll(const Options &opt, std::vector<Result> &results) {
+    const double t = opt.quick ? 0.02 : 0.5;
+    auto wanted = [&opt](const std::string &name) {
+        return opt.filter.empty() || name.find(opt.filter) != std::string::npos;
+    };
+    auto sizes = [&opt](std::vector<uint64_t> full, size_t quick_count) {
+        if (opt.quick) {
+            full.resize(std::min(full.size(), quick_count));
+        }
+        return full;
+    };
+
+    // Powers of 2, other 7-smooth lengths and lengths that need Bluestein's algorithm
+    for (uint64_t n : sizes({ 1024, 1000, 1031, 16384, 15000, 262144, 196608, 1048576, 1000000, 1000003 }, 3)) {
+        std::vector<cd> a(n);
+        std::vector<double> re = RandomCoeffs(n);
+        std::copy(re.begin(), re.end(), a.begin());
+        if (wanted("FFT")) {
+            results.push_back(Measure("FFT", n, t, [&]() { sink = std::real(FFT(a)[0]); }));
+        }
+        if (wanted("InverseFFT")) {
+            results.push_back(Measure("InverseFFT", n, t, [&]() { sink = std::real(InverseFFT(a)[0]); }));
+        }
+    }
+
+    // Degrees just below and at powers of 2, where padding to a power of 2 is worst
+    for (uint64_t n : sizes({ 1000, 1024, 10000, 16384, 100000, 131072, 1000000 }, 3)) {
+        if (wanted("PolyMult")) {
+            Polynomial p(RandomCoeffs(n + 1));
+            Polynomial q(RandomCoeffs(n + 1));
+            results.push_back(Measure("PolyMult", n, t, [&]() { sink = Polynomial::PolyMult(p, q)[n]; }));
+        }
+    }
+
+    // 20 bit coefficients, wide enough that exactness needs split limbs
+    for (uint64_t n : sizes({ 1000, 100000, 1000000 }, 2)) {
+        if (wanted("PolyMultExact")) {
+            std::uniform_int_distribution<int64_t> d(-(1 << 20), 1 << 20);
+            std::vector<double> a(n + 1), b(n + 1);
+            for (size_t i = 0; i <= n; i++) {
+                a[i] = static_cast<double>(d(rng));
+                b[i] = static_cast<double>(d(rng));
+            }
+            Polynomial p(a);
+            Polynomial q(b);
+            results.push_back(Measure("PolyMultExact", n, t, [&]() { sink = Polynomial::PolyMultExact(p, q)[n]; }));
+        }
+    }
+
+    for (uint64_t n : sizes({ 1000, 10000, 100000, 1000000 }, 2)) {
+        if (wanted("PolyInverse")) {
+            Polynomial p(UnitCoeffs(n));
+            results.push_back(Measure("PolyInverse", n, t, [&]() {
+                sink = Polynomial::PolyInverse(p, static_cast<uint32_t>(n))[n - 1];
+            }));
+        }
+    }
+
+    // Dividend of degree 2n by a monic divisor of degree n
+    for (uint64_t n : sizes({ 1000, 10000, 100000 }, 2)) {
+        if (wanted("PolyDiv")) {
+            Polynomial f(RandomCoeffs(2 * n + 1));
+            std::vector<double> g = UnitCoeffs(n + 1);
+            std::reverse(g.begin(), g.end());
+            Polynomial gp(g);
+            results.push_back(Measure("PolyDiv", n, t, [&]() { sink = Polynomial::PolyDiv(f, gp).first[0]; }));
+        }
+    }
+
+    for (uint64_t n : sizes({ 1000, 100000, 10000000 }, 2)) {
+        if (wanted("PolyEval")) {
+            Polynomial p(UnitCoeffs(n + 1));
+            results.push_back(Measure("PolyEval", n, t, [&]() { sink = p.PolyEval(0.999); }));
+        }
+    }
+
+    // Size is the number of interpolation points; Eval is at a point off the nodes
+    for (uint64_t n : sizes({ 100, 1000, 5000 }, 2)) {
+        if (wanted("PolyValGenerator::Eval")) {
+            std::vector<PtValPair> pts(n);
+            for (uint64_t i = 0; i < n; i++) {
+                pts[i] = { static_cast<double>(i) / n, std::sin(static_cast<double>(i)) };
+            }
+            PolyValGenerator gen(pts);
+            results.push_back(Measure("PolyValGenerator::Eval", n, t, [&]() { sink = gen.Eval(0.5 / n); }));
+        }
+    }
+
+    // Size is the number of starts, on a degree 50 polynomial
+    for (uint64_t n : sizes({ 100, 1000, 10000 }, 2)) {
+        if (wanted("NewtonsMethod")) {
+            Polynomial p(RandomCoeffs(51));
+            std::vector<double> guesses(n);
+            std::uniform_real_distribution<double> d(-2, 2);
+            for (double &g : guesses) {
+                g = d(rng);
+            }
+            results.push_back(Measure("NewtonsMethod", n, t, [&]() { sink = p.NewtonsMethod(guesses)[0]; }));
+        }
+    }
+
+    // Size is the number of inserts, followed by as many pops
+    for (uint64_t n : sizes({ 1000, 100000, 1000000 }, 2)) {
+        if (wanted("BinaryHeap")) {
+            std::vector<uint32_t> keys(n);
+            for (uint32_t &k : keys) {
+                k = static_cast<uint32_t>(rng());
+            }
+            results.push_back(Measure("BinaryHeap", n, t, [&]() {
+                BinaryHeap<uint32_t, uint32_t, max_heap_comp<uint32_t>> heap;
+                for (uint64_t i = 0; i < n; i++) {
+                    heap.Insert(keys[i], static_cast<uint32_t>(i));
+                }
+                uint64_t s = 0;
+                for (uint64_t i = 0; i < n; i++) {
+                    s += heap.Pop();
+                }
+                sink = static_cast<double>(s);
+            }));
+        }
+    }
+}
+
+static void WriteJson(std::ostream &out, const std::vector<Result> &results) {
+    out << "{\n";
+    out << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"name\": \"" << r.name << "\", \"size\": " << r.size
+            << ", \"threads\": " << r.threads << ", \"iterations\": " << r.iterations
+            << ", \"min_ns\": " << static_cast<uint64_t>(r.min_ns)
+            << ", \"median_ns\": " << static_cast<uint64_t>(r.median_ns)
+            << ", \"mean_ns\": " << static_cast<uint64_t>(r.mean_ns);
+        if (!r.counters.empty()) {
+            out << ", \"counters\": {";
+            for (size_t c = 0; c < r.counters.size(); c++) {
+                out << (c ? ", " : "") << "\"" << r.counters[c].first << "\": " << r.counters[c].second;
+            }
+            out << "}";
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+static std::vector<size_t> ParseList(const std::string &s) {
+    std::vector<size_t> list;
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t comma = s.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = s.size();
+        }
+        list.push_back(std::stoul(s.substr(pos, comma - pos)));
+        pos = comma + 1;
+    }
+    return list;
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--quick") {
+            opt.quick = true;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            opt.threads = ParseList(argv[++i]);
+        }
+        else if (arg == "--filter" && i + 1 < argc) {
+            opt.filter = argv[++i];
+        }
+        else if (arg == "--output" && i + 1 < argc) {
+            opt.output = argv[++i];
+        }
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--quick] [--threads 1,2,4] [--filter name] [--output file]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (opt.threads.empty()) {
+        size_t hw = std::max<size_t>(1, std::thread::hardware_concurrency());
+        for (size_t t = 1; t < hw; t <<= 1) {
+            opt.threads.push_back(t);
+        }
+        opt.threads.push_back(hw);
+    }
+
+    std::vector<Result> results;
+    for (size_t threads : opt.threads) {
+        SetThreadCount(threads);
+        RunAll(opt, results);
+    }
+
+    std::ofstream out(opt.output);
+    if (!out) {
+        std::cerr << "Cannot write " << opt.output << std::endl;
+        return 1;
+    }
+    WriteJson(out, results);
+    return 0;
+}
@@ -3,12 +3,6 @@
 
 
 int main() {
-    //auto t1 = std::chrono::high_resolution_clock::now();
-    //auto t2 = std::chrono::high_resolution_clock::now();
-    //auto duration = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
-    //std::cout << duration << std::endl;
-    //std::cout << std::this_thread::get_id() << std::endl;
-
     //std::vector<PtValPair> v = { {1,2}, {2,3}, {5,7} };
     //PolyValGenerator p = PolyValGenerator(v);
 
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "Instrumentation.h"
+
+/*
+    Counters of one thread. Only the owning thread writes them, so relaxed loads and stores
+    suffice; they are atomic only so that Take can read them while the thread runs.
+*/
+struct ThreadCounters {
+    std::atomic<uint64_t> counters[Instrumentation::NUM_COUNTERS];
+    std::atomic<uint64_t> fft_sizes[Instrumentation::FFT_SIZE_BUCKETS];
+
+    ThreadCounters();
+    ~ThreadCounters();
+
+    void Bump(std::atomic<uint64_t> &c, uint64_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void AddTo(Instrumentation::Snapshot &s) const {
+        for (int i = 0; i < Instrumentation::NUM_COUNTERS; i++) {
+            s.counters[i] += counters[i].load(std::memory_order_relaxed);
+        }
+        for (int i = 0; i < Instrumentation::FFT_SIZE_BUCKETS; i++) {
+            s.fft_sizes[i] += fft_sizes[i].load(std::memory_order_relaxed);
+        }
+    }
+};
+
+/* Every live thread's counters, and the totals of exited threads */
+struct Registry {
+    std::mutex mutex;
+    std::vector<const ThreadCounters *> threads;
+    Instrumentation::Snapshot retired;
+    Instrumentation::Snapshot baseline;
+
+    Registry() {
+        std::memset(&retired, 0, sizeof(retired));
+        std::memset(&baseline, 0, sizeof(baseline));
+    }
+
+    /* Sum over all threads ever. The caller holds the mutex. */
+    Instrumentation::Snapshot Totals() const {
+        Instrumentation::Snapshot s = retired;
+        for (const ThreadCounters *t : threads) {
+            t->AddTo(s);
+        }
+        return s;
+    }
+};
+
+static Registry &GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+ThreadCounters::ThreadCounters() {
+    for (std::atomic<uint64_t> &c : counters) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    for (std::atomic<uint64_t> &c : fft_sizes) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    Registry &r = GetRegistry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threads.push_back(this);
+}
+
+ThreadCounters::~ThreadCounters() {
+    Registry &r = GetRegistry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    AddTo(r.retired);
+    r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+}
+
+static ThreadCounters &Local() {
+    static thread_local ThreadCounters counters;
+    return counters;
+}
+
+uint64_t Instrumentation::Snapshot::operator[](Counter c) const {
+    return counters[c];
+}
+
+void Instrumentation::Add(Counter c, uint64_t n) {
+    ThreadCounters &t = Local();
+    t.Bump(t.counters[c], n);
+}
+
+void Instrumentation::RecordFFT(uint64_t n) {
+    int bucket = 0;
+    while (bucket + 1 < FFT_SIZE_BUCKETS && (n >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+    ThreadCounters &t = Local();
+    t.Bump(t.counters[FFT_CALLS], 1);
+    t.Bump(t.counters[FFT_POINTS], n);
+    t.Bump(t.fft_sizes[bucket], 1);
+}
+
+Instrumentation::Snapshot Instrumentation::Take() {
+    Registry &r = GetRegistry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    Snapshot s = r.Totals();
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        s.counters[i] -= r.baseline.counters[i];
+    }
+    for (int i = 0; i < FFT_SIZE_BUCKETS; i++) {
+        s.fft_sizes[i] -= r.baseline.fft_sizes[i];
+    }
+    return s;
+}
+
+void Instrumentation::Reset() {
+    // Threads own their counters, so rather than clearing them, remember where zero is
+    Registry &r = GetRegistry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.baseline = r.Totals();
+}
+
+const char *Instrumentation::Name(Counter c) {
+    static const char *names[NUM_COUNTERS] = {
+        "fft_calls", "fft_points", "fft_bluestein", "fft_ns",
+        "mult_schoolbook", "mult_fft", "mult_ntt", "mult_split", "mult_ns",
+        "poly_copies", "poly_moves", "bytes_allocated",
+        "tasks", "task_wait_ns", "task_run_ns",
+        "newton_iterations"
+    };
+    return names[c];
+}
+
+Instrumentation::ScopedTimer::ScopedTimer(Counter c) :
+    m_counter(c),
+    m_start(std::chrono::steady_clock::now()) { }
+
+Instrumentation::ScopedTimer::~ScopedTimer() {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+    Add(m_counter, static_cast<uint64_t>(ns.count()));
+}
+
+Instrumentation::TaskTimer::TaskTimer(std::chrono::steady_clock::time_point submitted) :
+    m_start(std::chrono::steady_clock::now()) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(m_start - submitted);
+    Add(TASKS, 1);
+    Add(TASK_WAIT_NS, static_cast<uint64_t>(ns.count()));
+}
+
+Instrumentation::TaskTimer::~TaskTimer() {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+    Add(TASK_RUN_NS, static_cast<uint64_t>(ns.count()));
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+/*!
+    @file
+    \brief Opt-in counters and timers describing what the library does: transforms, multiplication
+    paths, copies and moves of polynomials, buffer allocations and ParallelFor task latency.
+
+    Define POLY_INSTRUMENTATION (the CMake option of the same name) to enable them. When it is not
+    defined, the POLY_* macros below expand to nothing and every snapshot is zero.
+
+    Each thread increments its own counters, without locks or atomic read-modify-writes.
+    Instrumentation::Take sums the counters of every thread, including threads that have exited.
+*/
+
+class Instrumentation
+{
+public:
+    enum Counter {
+        FFT_CALLS,          /*!< Forward and inverse transforms */
+        FFT_POINTS,         /*!< Sum of the transform lengths */
+        FFT_BLUESTEIN,      /*!< Transforms whose length needed Bluestein's algorithm */
+        FFT_NS,             /*!< Time spent in transforms */
+        MULT_SCHOOLBOOK,    /*!< Products small enough for the quadratic algorithm */
+        MULT_FFT,           /*!< Products via the floating point FFT */
+        MULT_NTT,           /*!< Products via the NTT, for ModPolynomial */
+        MULT_SPLIT,         /*!< Exact products that needed coefficients split into limbs */
+        MULT_NS,            /*!< Time spent in Polynomial::PolyMult */
+        POLY_COPIES,        /*!< Polynomial copy constructions */
+        POLY_MOVES,         /*!< Polynomial and PolyValGenerator move constructions and assignments */
+        BYTES_ALLOCATED,    /*!< Bytes of coefficient and transform buffers allocated */
+        TASKS,              /*!< ParallelFor tasks run on other threads */
+        TASK_WAIT_NS,       /*!< Time from submitting those tasks to their start */
+        TASK_RUN_NS,        /*!< Time running those tasks */
+        NEWTON_ITERATIONS,  /*!< Iterations of the single start NewtonsMethod */
+        NUM_COUNTERS
+    };
+
+    /*! Transforms of length in \f$ [2^k, 2^{k+1}) \f$ are counted in bucket k */
+    static const int FFT_SIZE_BUCKETS = 33;
+
+    /*! Totals of every counter at one point in time */
+    struct Snapshot {
+        uint64_t counters[NUM_COUNTERS];
+        uint64_t fft_sizes[FFT_SIZE_BUCKETS];
+
+        /*! \return the value of counter c */
+        uint64_t operator[](Counter c) const;
+    };
+
+    /*! Adds n to counter c of the calling thread */
+    static void Add(Counter c, uint64_t n = 1);
+
+    /*! Counts a transform of length n */
+    static void RecordFFT(uint64_t n);
+
+    /*! \return the totals over all threads since the last Reset */
+    static Snapshot Take();
+
+    /*! Starts counting from zero again */
+    static void Reset();
+
+    /*! \return the name of counter c, e.g. "fft_calls" */
+    static const char *Name(Counter c);
+
+    /*! Adds the lifetime of the object in nanoseconds to a counter */
+    class ScopedTimer {
+    private:
+        Counter m_counter;
+        std::chrono::steady_clock::time_point m_start;
+
+    public:
+        ScopedTimer(Counter c);
+        ~ScopedTimer();
+    };
+
+    /*! Records the wait and run time of a task started on another thread */
+    class TaskTimer {
+    private:
+        std::chrono::steady_clock::time_point m_start;
+
+    public:
+        /*! \param [in] submitted when the task was handed to std::async */
+        TaskTimer(std::chrono::steady_clock::time_point submitted);
+        ~TaskTimer();
+    };
+};
+
+#ifdef POLY_INSTRUMENTATION
+/*! Adds n to the named counter, e.g. POLY_COUNT(MULT_FFT, 1) */
+#define POLY_COUNT(counter, n) Instrumentation::Add(Instrumentation::counter, (n))
+/*! Counts a transform of length n */
+#define POLY_RECORD_FFT(n) Instrumentation::RecordFFT(n)
+/*! Times the rest of the enclosing scope into the named counter */
+#define POLY_TIMER(counter) Instrumentation::ScopedTimer poly_scoped_timer(Instrumentation::counter)
+#else
+#define POLY_COUNT(counter, n) ((void)0)
+#define POLY_RECORD_FFT(n) ((void)0)
+#define POLY_TIMER(counter) ((void)0)
+#endif
@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <cstdio>         // std::remove
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX          // keeps windows.h from defining min and max macros over std::min
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedPolynomial.h"
+#include "Util.h"
+
+/* Bytes of block spectra computed at a time while spilling a factor */
+static const size_t SPILL_BUDGET = size_t(512) << 20;
+
+static const char MAGIC[8] = { 'P', 'O', 'L', 'Y', 'B', 'I', 'N', '1' };
+static const size_t HEADER_BYTES = 16;
+
+/* Maps the whole file read-only. Returns nullptr for an empty file. */
+static const char *MapFile(const std::string &path, size_t &bytes) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error("Cannot read the size of " + path);
+    }
+    bytes = static_cast<size_t>(size.QuadPart);
+    if (bytes == 0) {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    // The view keeps the mapping alive after the handles are closed
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (view == NULL) {
+        throw std::runtime_error("Cannot map " + path);
+    }
+    return static_cast<const char *>(view);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot read the size of " + path);
+    }
+    bytes = static_cast<size_t>(st.st_size);
+    if (bytes == 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void *view = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("Cannot map " + path);
+    }
+    return static_cast<const char *>(view);
+#endif
+}
+
+static void UnmapFile(const char *view, size_t bytes) {
+    if (view == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+#else
+    munmap(const_cast<char *>(view), bytes);
+#endif
+}
+
+/* Opens path for writing and writes the header for count coefficients */
+static std::ofstream CreatePolyFile(const std::string &path, uint64_t count) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot create " + path);
+    }
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    return out;
+}
+
+/* Deletes a scratch file when it goes out of scope */
+struct ScratchFile {
+    std::string path;
+
+    ~ScratchFile() {
+        std::remove(path.c_str());
+    }
+};
+
+/* Read-only mapping of a scratch file of spectra */
+struct SpectrumView {
+    const char *view;
+    size_t bytes;
+
+    SpectrumView(const std::string &path) : bytes(0) {
+        view = MapFile(path, bytes);
+    }
+
+    ~SpectrumView() {
+        UnmapFile(view, bytes);
+    }
+
+    const cd *Block(size_t b, size_t half) const {
+        return reinterpret_cast<const cd *>(view) + b * half;
+    }
+};
+
+MappedPolynomial::MappedPolynomial(const std::string &path) : m_bytes(0) {
+    m_view = MapFile(path, m_bytes);
+
+    uint64_t count = 0;
+    bool valid = m_bytes >= HEADER_BYTES && std::memcmp(m_view, MAGIC, sizeof(MAGIC)) == 0;
+    if (valid) {
+        std::memcpy(&count, m_view + sizeof(MAGIC), sizeof(count));
+        valid = count > 0 && count == (m_bytes - HEADER_BYTES) / sizeof(double);
+    }
+    if (!valid) {
+        UnmapFile(m_view, m_bytes);
+        throw std::runtime_error(path + " is not a polynomial file");
+    }
+
+    m_count = static_cast<size_t>(count);
+    m_coeffs = reinterpret_cast<const double *>(m_view + HEADER_BYTES);
+}
+
+MappedPolynomial::MappedPolynomial(MappedPolynomial &&other) noexcept :
+    m_view(other.m_view),
+    m_bytes(other.m_bytes),
+    m_coeffs(other.m_coeffs),
+    m_count(other.m_count) {
+    other.m_view = nullptr;
+    other.m_bytes = 0;
+    other.m_coeffs = nullptr;
+    other.m_count = 0;
+}
+
+MappedPolynomial::~MappedPolynomial() {
+    UnmapFile(m_view, m_bytes);
+}
+
+size_t MappedPolynomial::size() const {
+    return m_count;
+}
+
+const double *MappedPolynomial::data() const {
+    return m_coeffs;
+}
+
+double MappedPolynomial::operator[](const size_t &i) const {
+    return i < m_count ? m_coeffs[i] : 0;
+}
+
+void MappedPolynomial::Save(const std::string &path, const double *coeffs, size_t count) {
+    std::ofstream out = CreatePolyFile(path, count);
+    out.write(reinterpret_cast<const char *>(coeffs), count * sizeof(double));
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+/*
+    Writes the first half (N / 2 + 1 values) of the length N transform of each block of
+    B coefficients of p to path. The rest of the transform of a real block is conjugate symmetric.
+*/
+static void SpillSpectra(const MappedPolynomial &p, size_t B, uint32_t N, const std::string &path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot create " + path);
+    }
+
+    const size_t half = N / 2 + 1;
+    const size_t blocks = (p.size() + B - 1) / B;
+    // Enough blocks at a time to keep every thread busy, two blocks per transform, as long as
+    // their half spectra and the transform buffers (about half + N values per block) fit the budget
+    const size_t per_block = (half + N) * sizeof(cd);
+    size_t batch = std::min(2 * GetThreadCount(), SPILL_BUDGET / per_block) & ~size_t(1);
+    batch = std::max<size_t>(batch, 2);
+    std::vector<cd> spectra(batch * half);
+
+    for (size_t first = 0; first < blocks; first += batch) {
+        size_t count = std::min(batch, blocks - first);
+        ParallelFor((count + 1) / 2, [&](size_t begin, size_t end) {
+            std::vector<cd> z(N);
+            for (size_t j = begin; j < end; j++) {
+                // Blocks b0 and b1 as the real and imaginary parts of one transform
+                size_t b0 = first + 2 * j;
+                size_t b1 = b0 + 1;
+                std::fill(z.begin(), z.end(), cd(0, 0));
+                for (size_t k = 0; k < B; k++) {
+                    z[k] = cd(p[b0 * B + k], b1 < first + count ? p[b1 * B + k] : 0);
+                }
+
+                std::vector<cd> Z = FFT(z);
+                cd *X0 = &spectra[2 * j * half];
+                cd *X1 = X0 + half;
+                for (size_t k = 0; k < half; k++) {
+                    cd a = Z[k];
+                    cd b = std::conj(Z[(N - k) % N]);
+                    X0[k] = (a + b) * 0.5;
+                    if (b1 < first + count) {
+                        X1[k] = (a - b) * cd(0, -0.5);
+                    }
+                }
+            }
+        });
+        out.write(reinterpret_cast<const char *>(spectra.data()), count * half * sizeof(cd));
+    }
+
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+void MappedPolynomial::PolyMultFile(const std::string &p_path, const std::string &q_path,
+                                    const std::string &out_path, size_t block_size) {
+    if (block_size == 0 || block_size > (1u << 30)) {
+        throw std::invalid_argument("Block size must be between 1 and 2^30");
+    }
+
+    MappedPolynomial p(p_path);
+    MappedPolynomial q(q_path);
+    const size_t B = block_size;
+    const uint32_t N = smooth_round(static_cast<uint32_t>(2 * B - 1));
+    const size_t half = N / 2 + 1;
+    const size_t np = (p.size() + B - 1) / B;
+    const size_t nq = (q.size() + B - 1) / B;
+    const uint64_t total = p.size() + q.size() - 1;
+
+    ScratchFile p_scratch{ out_path + ".p.spectrum" };
+    ScratchFile q_scratch{ out_path + ".q.spectrum" };
+    SpillSpectra(p, B, N, p_scratch.path);
+    if (q_path != p_path) {
+        SpillSpectra(q, B, N, q_scratch.path);
+    }
+    SpectrumView P(p_scratch.path);
+    SpectrumView Q(q_path != p_path ? q_scratch.path : p_scratch.path);
+
+    std::ofstream out = CreatePolyFile(out_path, total);
+    std::vector<cd> S(N);
+    std::vector<double> carry(B, 0);   // the part of the last diagonal past its output block
+    std::vector<double> block(B);
+    uint64_t written = 0;
+
+    for (size_t s = 0; written < total; s++) {
+        // Diagonal s of the block product: the sum of P_i Q_j over i + j = s
+        if (s < np + nq - 1) {
+            size_t lo = s >= nq ? s - nq + 1 : 0;
+            size_t hi = std::min(s, np - 1);
+            ParallelFor(half, [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; k++) {
+                    S[k] = 0;
+                }
+                for (size_t i = lo; i <= hi; i++) {
+                    const cd *Pi = P.Block(i, half);
+                    const cd *Qj = Q.Block(s - i, half);
+                    for (size_t k = begin; k < end; k++) {
+                        S[k] += Pi[k] * Qj[k];
+                    }
+                }
+            }, 1 << 12);
+            for (size_t k = half; k < N; k++) {
+                S[k] = std::conj(S[N - k]);
+            }
+        }
+        else {
+            std::fill(S.begin(), S.end(), cd(0, 0));
+        }
+        std::vector<cd> y = InverseFFT(S);
+
+        // y has 2B - 1 coefficients: the first B complete output block s with the carry
+        for (size_t k = 0; k < B; k++) {
+            block[k] = roundError(carry[k] + std::real(y[k]));
+            carry[k] = k + B < N ? std::real(y[k + B]) : 0;
+        }
+        size_t count = static_cast<size_t>(std::min<uint64_t>(B, total - written));
+        out.write(reinterpret_cast<const char *>(block.data()), count * sizeof(double));
+        written += count;
+    }
+
+    if (!out) {
+        throw std::runtime_error("Cannot write " + out_path);
+    }
+}
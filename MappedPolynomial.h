@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Util.h"
+
+
+/*!
+    \class MappedPolynomial
+
+    \brief Read-only view of the coefficients of a polynomial stored in the binary format,
+    memory-mapped so they are paged in from disk on demand instead of copied into RAM.
+
+    \remark Binary format: the 8 bytes "POLYBIN1", the number of coefficients as a uint64,
+    then the coefficients as doubles from the constant term up. Integers and doubles are in
+    the native byte order, which is little-endian on every supported platform.
+    The header is 16 bytes, so the coefficients are aligned.
+
+    \remark Polynomial::PolySave and Polynomial::PolyLoad read and write the same format
+    for polynomials that fit in memory.
+*/
+class MappedPolynomial
+{
+private:
+    const char *m_view;
+    size_t m_bytes;
+    const double *m_coeffs;
+    size_t m_count;
+
+public:
+    /*!
+        \brief Maps a polynomial file
+        \param [in] path the file, written by Save or Polynomial::PolySave
+
+        \throw std::runtime_error Occurs when the file cannot be mapped, or is not a polynomial file
+    */
+    MappedPolynomial(const std::string &);
+
+    /* Remove copy constructor */
+    MappedPolynomial(const MappedPolynomial &) = delete;
+    MappedPolynomial &operator=(const MappedPolynomial &) = delete;
+
+    /*! Move Constructor */
+    MappedPolynomial(MappedPolynomial &&) noexcept;
+
+    /*! Unmaps the file */
+    ~MappedPolynomial();
+
+    /*! \return the number of coefficients, one more than the degree */
+    size_t size() const;
+
+    /*! \return the coefficients, valid for the lifetime of this object */
+    const double *data() const;
+
+    /*! \return the coefficient of \f$ x^i \f$, which is 0 past the degree */
+    double operator[](const size_t &i) const;
+
+    /*!
+        \brief Writes coefficients in the binary format
+        \param [in] path the file to create or overwrite
+        \param [in] coeffs the coefficients, from the constant term up
+        \param [in] count the number of coefficients. Must be positive.
+
+        \throw std::runtime_error Occurs when the file cannot be written
+    */
+    static void Save(const std::string &, const double *, size_t);
+
+    /*!
+        \brief Out-of-core polynomial multiplication, for operands and products larger than memory
+        \param [in] p_path the file of the first factor
+        \param [in] q_path the file of the second factor
+        \param [in] out_path the file to write the product to. Must differ from both inputs.
+        \param [in] block_size the number of coefficients per block. Optional.
+
+        \details The factors are cut into blocks of block_size coefficients. The half spectrum of
+        every block is computed once and spilled to a temporary file next to the output, about
+        twice the size of the factor. Output block k is the inverse transform of the sum over
+        \f$ i + j = k \f$ of the products of block spectra, plus the overflow from block k - 1,
+        so each output block is written once and in order.
+
+        The working set is a few transforms of length \f$ 2 \cdot \f$ block_size per thread, independent of
+        the degrees. Spilling transforms up to two blocks per thread at a time, but no more than fit
+        in about 512 MiB, so with large blocks it uses fewer threads rather than more memory. The number of spectrum products grows with the product of the block counts,
+        so block_size should be as large as memory allows.
+        Like Polynomial::PolyMult, coefficients within epsilon of an integer are rounded.
+
+        \throw std::runtime_error Occurs when a file cannot be read or written
+    */
+    static void PolyMultFile(const std::string &, const std::string &, const std::string &,
+                             size_t block_size = 1 << 20);
+};
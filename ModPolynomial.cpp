@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <future>         // std::async, std::future
+#include <iostream>       // std::cout
+#include <stdexcept>
+#include <vector>
+
+#include "Instrumentation.h"
+#include "ModPolynomial.h"
+#include "Util.h"
+
+ModPolynomial::ModPolynomial(const std::vector<int64_t> &A) {
+    m_coeffs.resize(A.size());
+    for (size_t i = 0; i < A.size(); i++) {
+        int64_t r = A[i] % static_cast<int64_t>(MOD);
+        m_coeffs[i] = static_cast<uint32_t>(r < 0 ? r + MOD : r);
+    }
+    Normalize();
+}
+
+void ModPolynomial::Normalize() {
+    while (!m_coeffs.empty() && m_coeffs.back() == 0) {
+        m_coeffs.pop_back();
+    }
+}
+
+int64_t ModPolynomial::Degree() const {
+    return static_cast<int64_t>(m_coeffs.size()) - 1;
+}
+
+uint32_t ModPolynomial::operator[](const size_t &i) const {
+    return i < m_coeffs.size() ? m_coeffs[i] : 0;
+}
+
+ModPolynomial ModPolynomial::ShiftRight(const ModPolynomial &p, size_t k) {
+    ModPolynomial r({});
+    if (k < p.m_coeffs.size()) {
+        r.m_coeffs.assign(p.m_coeffs.begin() + k, p.m_coeffs.end());
+    }
+    return r;
+}
+
+ModPolynomial ModPolynomial::Truncate(const ModPolynomial &p, size_t n) {
+    ModPolynomial r({});
+    r.m_coeffs.assign(p.m_coeffs.begin(), p.m_coeffs.begin() + std::min(n, p.m_coeffs.size()));
+    r.Normalize();
+    return r;
+}
+
+ModPolynomial ModPolynomial::PolyMult(const ModPolynomial &p, const ModPolynomial &q) {
+    ModPolynomial r({});
+    if (p.m_coeffs.empty() || q.m_coeffs.empty()) {
+        return r;
+    }
+
+    size_t num_coeffs = p.m_coeffs.size() + q.m_coeffs.size() - 1;
+    if (std::min(p.m_coeffs.size(), q.m_coeffs.size()) <= 32) {
+        POLY_COUNT(MULT_SCHOOLBOOK, 1);
+        std::vector<uint64_t> acc(num_coeffs, 0);
+        for (size_t i = 0; i < p.m_coeffs.size(); i++) {
+            for (size_t j = 0; j < q.m_coeffs.size(); j++) {
+                acc[i + j] = (acc[i + j] + static_cast<uint64_t>(p.m_coeffs[i]) * q.m_coeffs[j]) % MOD;
+            }
+        }
+        r.m_coeffs.assign(acc.begin(), acc.end());
+        r.Normalize();
+        return r;
+    }
+
+    POLY_COUNT(MULT_NTT, 1);
+    uint32_t N = pow2_round(num_coeffs);
+    std::vector<uint32_t> a(p.m_coeffs), b(q.m_coeffs);
+    a.resize(N, 0);
+    b.resize(N, 0);
+
+    // Transform the larger products' operands in parallel, as Polynomial::PolyMult does
+    std::future<std::vector<uint32_t>> f = Async(N >= (1 << 14), NTT, std::cref(b));
+    std::vector<uint32_t> A = NTT(a);
+    std::vector<uint32_t> B = f.get();
+    for (uint32_t i = 0; i < N; i++) {
+        A[i] = static_cast<uint32_t>(static_cast<uint64_t>(A[i]) * B[i] % MOD);
+    }
+
+    r.m_coeffs = InverseNTT(A);
+    r.m_coeffs.resize(num_coeffs);
+    r.Normalize();
+    return r;
+}
+
+ModPolynomial ModPolynomial::PolyInverse(const ModPolynomial &p, size_t t) {
+    if (p[0] == 0) {
+        throw std::invalid_argument("Inverse does not exist");
+    }
+
+    size_t m = 1;
+    ModPolynomial inv({ mod_inverse(p[0]) });
+    while (m < t) {
+        m <<= 1;
+        // inv = 2 * inv - inv * (A * inv)
+        ModPolynomial e = Truncate(PolyMult(Truncate(p, m), inv), m);
+        inv = Truncate(inv * 2 - Truncate(PolyMult(inv, e), m), m);
+    }
+    return Truncate(inv, t);
+}
+
+ModPolynomial::PolyPair ModPolynomial::PolyDiv(const ModPolynomial &f, const ModPolynomial &g) {
+    if (g.m_coeffs.empty()) {
+        throw std::invalid_argument("Division by zero polynomial");
+    }
+    if (f.Degree() < g.Degree()) {
+        return PolyPair(ModPolynomial({}), f);
+    }
+
+    size_t N = f.Degree() - g.Degree() + 1;
+    ModPolynomial q({});
+    if (std::min<size_t>(N, g.m_coeffs.size()) <= 64) {
+        // Long division
+        std::vector<uint32_t> r(f.m_coeffs);
+        q.m_coeffs.assign(N, 0);
+        uint64_t lc_inv = mod_inverse(g.m_coeffs.back());
+        size_t dg = g.Degree();
+        for (size_t i = N; i-- > 0;) {
+            uint64_t c = r[i + dg] * lc_inv % MOD;
+            q.m_coeffs[i] = static_cast<uint32_t>(c);
+            if (c == 0) {
+                continue;
+            }
+            for (size_t j = 0; j <= dg; j++) {
+                r[i + j] = static_cast<uint32_t>((r[i + j] + (MOD - c) * g.m_coeffs[j]) % MOD);
+            }
+        }
+        q.Normalize();
+        ModPolynomial rem({});
+        rem.m_coeffs.assign(r.begin(), r.begin() + dg);
+        rem.Normalize();
+        return PolyPair(q, rem);
+    }
+
+    // The reversed quotient is the first N terms of rev(f) / rev(g)
+    ModPolynomial fR({}), gR({});
+    fR.m_coeffs.assign(f.m_coeffs.rbegin(), f.m_coeffs.rbegin() + N);
+    gR.m_coeffs.assign(g.m_coeffs.rbegin(), g.m_coeffs.rend());
+    fR.Normalize();
+    gR.Normalize();
+    ModPolynomial qR = Truncate(PolyMult(fR, PolyInverse(gR, N)), N);
+    q.m_coeffs = qR.m_coeffs;
+    q.m_coeffs.resize(N, 0);
+    std::reverse(q.m_coeffs.begin(), q.m_coeffs.end());
+    q.Normalize();
+
+    ModPolynomial r = Truncate(f - Truncate(PolyMult(q, g), g.Degree()), g.Degree());
+    return PolyPair(q, r);
+}
+
+ModPolynomial::Matrix::Matrix() : m({ ModPolynomial({ 1 }), ModPolynomial({}),
+                                      ModPolynomial({}), ModPolynomial({ 1 }) }) { }
+
+ModPolynomial::Matrix ModPolynomial::Matrix::operator*(const Matrix &other) const {
+    Matrix r;
+    r.m[0] = PolyMult(m[0], other.m[0]) + PolyMult(m[1], other.m[2]);
+    r.m[1] = PolyMult(m[0], other.m[1]) + PolyMult(m[1], other.m[3]);
+    r.m[2] = PolyMult(m[2], other.m[0]) + PolyMult(m[3], other.m[2]);
+    r.m[3] = PolyMult(m[2], other.m[1]) + PolyMult(m[3], other.m[3]);
+    return r;
+}
+
+void ModPolynomial::Matrix::Apply(ModPolynomial &a, ModPolynomial &b) const {
+    ModPolynomial c = PolyMult(m[0], a) + PolyMult(m[1], b);
+    b = PolyMult(m[2], a) + PolyMult(m[3], b);
+    a = c;
+}
+
+ModPolynomial::Matrix ModPolynomial::EuclidStep(const ModPolynomial &q) {
+    Matrix E;
+    E.m[0] = ModPolynomial({});
+    E.m[1] = ModPolynomial({ 1 });
+    E.m[2] = ModPolynomial({ 1 });
+    E.m[3] = ModPolynomial({}) - q;
+    return E;
+}
+
+ModPolynomial::Matrix ModPolynomial::HalfGcd(const ModPolynomial &a, const ModPolynomial &b, QuotientLog *log) {
+    int64_t m = (a.Degree() + 1) / 2;
+    if (b.Degree() < m) {
+        return Matrix();
+    }
+
+    if (a.Degree() <= 64) {
+        // Plain Euclidean steps until the remainder drops below degree m
+        Matrix M;
+        ModPolynomial c = a, d = b;
+        while (d.Degree() >= m) {
+            PolyPair qr = PolyDiv(c, d);
+            if (log) {
+                log->push_back({ qr.first.Degree(), qr.first.m_coeffs.back() });
+            }
+            M = EuclidStep(qr.first) * M;
+            c = d;
+            d = qr.second;
+        }
+        return M;
+    }
+
+    // The quotients of the top halves are the first quotients of (a, b)
+    Matrix R = HalfGcd(ShiftRight(a, m), ShiftRight(b, m), log);
+    ModPolynomial c = a, d = b;
+    R.Apply(c, d);
+    if (d.Degree() < m) {
+        return R;
+    }
+
+    PolyPair qr = PolyDiv(c, d);
+    if (log) {
+        log->push_back({ qr.first.Degree(), qr.first.m_coeffs.back() });
+    }
+    Matrix E = EuclidStep(qr.first);
+
+    // Now m <= deg d < 3/2 m, and the top 2(deg d - m) degrees of (d, r) finish the job
+    int64_t k = 2 * m - d.Degree();
+    Matrix S = HalfGcd(ShiftRight(d, k), ShiftRight(qr.second, k), log);
+    return S * (E * R);
+}
+
+ModPolynomial::Matrix ModPolynomial::GcdMatrix(ModPolynomial a, ModPolynomial b, QuotientLog *log) {
+    Matrix M;
+    while (b.Degree() >= 0) {
+        if (a.Degree() > b.Degree()) {
+            Matrix H = HalfGcd(a, b, log);
+            H.Apply(a, b);
+            M = H * M;
+            if (b.Degree() < 0) {
+                break;
+            }
+        }
+
+        PolyPair qr = PolyDiv(a, b);
+        if (log) {
+            log->push_back({ qr.first.Degree(), qr.first.m_coeffs.back() });
+        }
+        M = EuclidStep(qr.first) * M;
+        a = b;
+        b = qr.second;
+    }
+    return M;
+}
+
+ModPolynomial ModPolynomial::PolyGcd(const ModPolynomial &a, const ModPolynomial &b) {
+    return PolyExtGcd(a, b).gcd;
+}
+
+ModPolynomial::ExtGcdResult ModPolynomial::PolyExtGcd(const ModPolynomial &a, const ModPolynomial &b) {
+    Matrix M = GcdMatrix(a, b, nullptr);
+    ModPolynomial g = PolyMult(M.m[0], a) + PolyMult(M.m[1], b);
+    if (g.m_coeffs.empty()) {
+        return { g, M.m[0], M.m[1] };
+    }
+
+    uint32_t lc_inv = mod_inverse(g.m_coeffs.back());
+    return { g * lc_inv, M.m[0] * lc_inv, M.m[1] * lc_inv };
+}
+
+uint32_t ModPolynomial::PolyResultant(const ModPolynomial &a, const ModPolynomial &b) {
+    if (a.m_coeffs.empty() || b.m_coeffs.empty()) {
+        return 0;
+    }
+
+    // res(a, b) = (-1)^{deg a deg b} res(b, a), so start with deg a >= deg b
+    uint64_t res = 1;
+    const ModPolynomial *f = &a, *g = &b;
+    if (a.Degree() < b.Degree()) {
+        std::swap(f, g);
+        if ((a.Degree() & 1) && (b.Degree() & 1)) {
+            res = MOD - 1;
+        }
+    }
+    if (g->Degree() == 0) {
+        return static_cast<uint32_t>(res * mod_pow(g->m_coeffs[0], f->Degree()) % MOD);
+    }
+
+    QuotientLog log;
+    GcdMatrix(*f, *g, &log);
+
+    /*
+        Walk the remainder sequence r_0 = f, r_1 = g, ... with r_{i-1} = q_i r_i + r_{i+1}:
+        deg r_{i+1} = deg r_i - deg q_{i+1} and lc(r_{i+1}) = lc(r_i) / lc(q_{i+1}).
+        Each step contributes res(r_{i-1}, r_i) = (-1)^{d_{i-1} d_i} lc(r_i)^{d_{i-1} - d_{i+1}} res(r_i, r_{i+1}).
+    */
+    int64_t d_prev = f->Degree(), d = g->Degree();
+    uint64_t lc = g->m_coeffs.back();
+    for (size_t i = 1; i < log.size(); i++) {
+        int64_t d_next = d - log[i].first;
+        if ((d_prev & 1) && (d & 1)) {
+            res = res * (MOD - 1) % MOD;
+        }
+        res = res * mod_pow(static_cast<uint32_t>(lc), d_prev - d_next) % MOD;
+        lc = lc * mod_inverse(log[i].second) % MOD;
+        d_prev = d;
+        d = d_next;
+    }
+
+    // The last non-zero remainder is the gcd, so the resultant vanishes unless it is a constant
+    if (d > 0) {
+        return 0;
+    }
+    return static_cast<uint32_t>(res * mod_pow(static_cast<uint32_t>(lc), d_prev) % MOD);
+}
+
+ModPolynomial ModPolynomial::operator*(const uint32_t &c) const {
+    ModPolynomial r({});
+    r.m_coeffs.resize(m_coeffs.size());
+    std::transform(m_coeffs.begin(),
+                   m_coeffs.end(),
+                   r.m_coeffs.begin(),
+                   [c](uint32_t x) { return static_cast<uint32_t>(static_cast<uint64_t>(x) * c % MOD); });
+    r.Normalize();
+    return r;
+}
+
+ModPolynomial ModPolynomial::operator*(const ModPolynomial &p) const {
+    return PolyMult(*this, p);
+}
+
+ModPolynomial::PolyPair ModPolynomial::operator/(const ModPolynomial &q) const {
+    return PolyDiv(*this, q);
+}
+
+ModPolynomial ModPolynomial::operator-(const ModPolynomial &q) const {
+    ModPolynomial r({});
+    r.m_coeffs.resize(std::max(m_coeffs.size(), q.m_coeffs.size()));
+    for (size_t i = 0; i < r.m_coeffs.size(); i++) {
+        uint32_t c = (*this)[i], d = q[i];
+        r.m_coeffs[i] = c >= d ? c - d : c + MOD - d;
+    }
+    r.Normalize();
+    return r;
+}
+
+ModPolynomial ModPolynomial::operator+(const ModPolynomial &q) const {
+    ModPolynomial r({});
+    r.m_coeffs.resize(std::max(m_coeffs.size(), q.m_coeffs.size()));
+    for (size_t i = 0; i < r.m_coeffs.size(); i++) {
+        uint64_t c = static_cast<uint64_t>((*this)[i]) + q[i];
+        r.m_coeffs[i] = static_cast<uint32_t>(c >= MOD ? c - MOD : c);
+    }
+    r.Normalize();
+    return r;
+}
+
+bool ModPolynomial::operator==(const ModPolynomial &q) const {
+    return m_coeffs == q.m_coeffs;
+}
+
+void ModPolynomial::PolyPrint() const {
+    if (m_coeffs.empty()) {
+        std::cout << "0" << std::endl;
+        return;
+    }
+    for (size_t i = 0; i + 1 < m_coeffs.size(); i++) {
+        std::cout << m_coeffs[i] << "x^" << i << " + ";
+    }
+    std::cout << m_coeffs.back() << "x^" << Degree() << std::endl;
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Util.h"
+
+
+/*!
+    \class ModPolynomial
+
+    \brief Represents a polynomial with coefficients in \f$ \mathbb{Z}/p \f$, where p is the prime MOD.
+
+    \remark Arithmetic is exact, so unlike Polynomial there is no rounding error to hide.
+    Products use the Number Theoretic Transform, and GCDs and resultants use the half-GCD
+    algorithm in \f$ O(n \log^2 n) \f$.
+
+    \remark Coefficients are stored without leading zeros. The zero polynomial has degree -1.
+*/
+class ModPolynomial
+{
+private:
+    std::vector<uint32_t> m_coeffs;
+
+    /*!
+        \brief 2x2 matrix of polynomials acting on pairs of remainders:
+        \f$ (a', b') = (m_{00} a + m_{01} b, m_{10} a + m_{11} b) \f$
+    */
+    struct Matrix {
+        std::vector<ModPolynomial> m;
+
+        /*! The identity matrix */
+        Matrix();
+
+        /*! \return the product this * other */
+        Matrix operator*(const Matrix &other) const;
+
+        /*! Applies the matrix to the pair (a, b) in-place */
+        void Apply(ModPolynomial &a, ModPolynomial &b) const;
+    };
+
+    /*! Quotient degree and leading coefficient, for each Euclidean step */
+    typedef std::vector<std::pair<int64_t, uint32_t>> QuotientLog;
+
+    /*! Removes leading zero coefficients */
+    void Normalize();
+
+    /*! \return the quotient of p by \f$ x^k \f$ */
+    static ModPolynomial ShiftRight(const ModPolynomial &, size_t);
+
+    /*! \return p mod \f$ x^n \f$ */
+    static ModPolynomial Truncate(const ModPolynomial &, size_t);
+
+    /*! \return the matrix \f$ \begin{pmatrix} 0 & 1 \\ 1 & -q \end{pmatrix} \f$ of one Euclidean step with quotient q */
+    static Matrix EuclidStep(const ModPolynomial &);
+
+    /*!
+        \brief Half-GCD
+        \param [in] a
+        \param [in] b with deg(b) < deg(a)
+        \param [out] log if not null, each quotient of the steps taken is appended to it
+        \return the matrix M of the Euclidean steps after which, for \f$ (a', b') = M(a, b) \f$,
+        \f$ \deg a' \geq \lceil \deg a / 2 \rceil > \deg b' \f$
+    */
+    static Matrix HalfGcd(const ModPolynomial &, const ModPolynomial &, QuotientLog *);
+
+    /*!
+        \return the matrix M of the whole Euclidean algorithm, such that \f$ M(a, b) = (\gcd(a, b), 0) \f$
+        \param [in] a
+        \param [in] b
+        \param [out] log if not null, each quotient of the steps taken is appended to it
+    */
+    static Matrix GcdMatrix(ModPolynomial, ModPolynomial, QuotientLog *);
+
+public:
+    typedef std::pair<ModPolynomial, ModPolynomial> PolyPair;
+
+    struct ExtGcdResult;
+
+    /*! Constructor
+        \param [in] A the coefficients, reduced mod MOD. Negative values are allowed.
+    */
+    ModPolynomial(const std::vector<int64_t> &);
+
+    /*! \return the degree, or -1 for the zero polynomial */
+    int64_t Degree() const;
+
+    /*! \return the coefficient of \f$ x^i \f$, which is 0 past the degree */
+    uint32_t operator[](const size_t &i) const;
+
+    /*!
+        \brief Polynomial multiplication via the NTT
+        \warning The product must have at most \f$ 2^{23} \f$ coefficients
+    */
+    static ModPolynomial PolyMult(const ModPolynomial &, const ModPolynomial &);
+
+    /*!
+        \brief Compute inverse series of a polynomial
+        \param [in] p the polynomial to be inverted
+        \param [in] t a positive integer, the number of terms of its inverse to compute
+        \return the first t terms of the power series of 1 / p
+
+        \throw std::invalid_argument Occurs when p(0) = 0
+    */
+    static ModPolynomial PolyInverse(const ModPolynomial &, size_t);
+
+    /*!
+        \brief Polynomial division
+        \param [in] f the dividend
+        \param [in] g the divisor
+        \return q(x) and r(x) such that \f$ f(x) = q(x)g(x) + r(x) \f$ and \f$ \deg r < \deg g \f$
+
+        \throw std::invalid_argument Occurs when g = 0
+    */
+    static PolyPair PolyDiv(const ModPolynomial &, const ModPolynomial &);
+
+    /*! \return the monic greatest common divisor of a and b, or 0 if both are 0 */
+    static ModPolynomial PolyGcd(const ModPolynomial &, const ModPolynomial &);
+
+    /*! \return the monic gcd g of a and b, with Bezout cofactors s and t such that \f$ s a + t b = g \f$ */
+    static ExtGcdResult PolyExtGcd(const ModPolynomial &, const ModPolynomial &);
+
+    /*!
+        \return the resultant of a and b mod MOD
+
+        \details Computed from the leading coefficients and degrees of the remainder sequence,
+        which the quotients found by the half-GCD determine.
+    */
+    static uint32_t PolyResultant(const ModPolynomial &, const ModPolynomial &);
+
+    /*! Polynomial-scalar multiplication */
+    ModPolynomial operator*(const uint32_t &c) const;
+
+    /*! Polynomial-polynomial multiplication */
+    ModPolynomial operator*(const ModPolynomial &p) const;
+
+    /*! Polynomial-polynomial division */
+    PolyPair operator/(const ModPolynomial &q) const;
+
+    /*! Polynomial-polynomial subtraction */
+    ModPolynomial operator-(const ModPolynomial &q) const;
+
+    /*! Polynomial-polynomial addition */
+    ModPolynomial operator+(const ModPolynomial &q) const;
+
+    /*! Polynomial equality */
+    bool operator==(const ModPolynomial &q) const;
+
+    /*! \brief Prints the polynomial to stdout */
+    void PolyPrint() const;
+};
+
+/*! Result of the extended Euclidean algorithm: \f$ s a + t b = g \f$ */
+struct ModPolynomial::ExtGcdResult {
+    ModPolynomial gcd;
+    ModPolynomial s;
+    ModPolynomial t;
+};
@@ -2,6 +2,7 @@
 #include <chrono>         // std::chrono::milliseconds
 #include <vector>
 
+#include "Instrumentation.h"
 #include "PolyValGenerator.h"
 #include "Polynomial.h"
 #include "Util.h"
@@ -17,12 +18,12 @@ PolyValGenerator::PolyValGenerator(const std::vector<PtValPair> &A) {
     m_L = Polynomial::PolyInterpolate(A);
 }
 
-PolyValGenerator::PolyValGenerator(const PolyValGenerator &&p) noexcept :
+PolyValGenerator::PolyValGenerator(PolyValGenerator &&p) noexcept :
     m_inputs(std::move(p.m_inputs)),
     m_outputs(std::move(p.m_outputs)),
     m_L(std::move(p.m_L))
 {
-    std::cout << "Move construct\n";
+    POLY_COUNT(POLY_MOVES, 1);
 }
 
 
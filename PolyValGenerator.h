@@ -23,7 +23,7 @@ public:
     PolyValGenerator(const PolyValGenerator &) = delete;
 
     /*! Move Constructor */
-    PolyValGenerator(const PolyValGenerator &&) noexcept;
+    PolyValGenerator(PolyValGenerator &&) noexcept;
 
     /*! Evaluates the generator at the point x */
     double Eval(double x) const;
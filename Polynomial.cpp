@@ -1,11 +1,23 @@
 
+#include <algorithm>
+#include <cmath>
 #include <future>         // std::async, std::future
 #include <iostream>       // std::cout
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
+#include "Instrumentation.h"
+#include "MappedPolynomial.h"
 #include "Polynomial.h"
 #include "Util.h"
 
+/* The baby steps of a composition are held at once, so they are capped at 256 MiB */
+static const size_t MAX_BABY_STEP_TERMS = size_t(1) << 25;
+
+/* The time of a multiply-add, relative to that of one coefficient of an FFT product per stage */
+static const double MULTIPLY_ADD_COST = 0.05;
+
 Polynomial::Polynomial(const std::vector<double> &A) { 
     if (A.empty()) {
         m_degree = 0;
@@ -15,25 +27,28 @@ Polynomial::Polynomial(const std::vector<double> &A) {
         m_degree = A.size() - 1;
         m_coeffs = std::vector<double>(A);
     }
+    POLY_COUNT(BYTES_ALLOCATED, m_coeffs.size() * sizeof(double));
 }
 
-Polynomial::Polynomial(const Polynomial &p) : m_degree(p.m_degree) {
-    m_coeffs = std::vector<double>(p.m_coeffs);
-    std::cout << "Copied\n";
+Polynomial::Polynomial(const Polynomial &p) :
+    m_coeffs(p.m_coeffs),
+    m_degree(p.m_degree) {
+    POLY_COUNT(POLY_COPIES, 1);
+    POLY_COUNT(BYTES_ALLOCATED, m_coeffs.size() * sizeof(double));
 }
 
-Polynomial::Polynomial(const Polynomial &&p) noexcept :
-    m_degree(std::move(p.m_degree)),
-    m_coeffs(std::move(p.m_coeffs)) {
-    std::cout << "Move construct\n";
+Polynomial::Polynomial(Polynomial &&p) noexcept :
+    m_coeffs(std::move(p.m_coeffs)),
+    m_degree(p.m_degree) {
+    POLY_COUNT(POLY_MOVES, 1);
 }
 
 Polynomial &Polynomial::operator=(Polynomial &&other) noexcept {
     if (this != &other) {
-        m_degree = std::move(other.m_degree);
+        m_degree = other.m_degree;
         m_coeffs = std::move(other.m_coeffs);
     }
-    std::cout << "Move assign\n";
+    POLY_COUNT(POLY_MOVES, 1);
     return *this;
 }
 
@@ -59,30 +74,41 @@ Polynomial Polynomial::ReversePolynomial(const Polynomial &p) {
 
 std::vector<cd> Polynomial::PolyMultHelper(const Polynomial &p, uint32_t N) {
     std::vector<double> p_coeffs(p.m_coeffs);
-    
-    while (p_coeffs.size() < N) {
-        p_coeffs.push_back(0);
-    }
+    p_coeffs.resize(N, 0);
+    POLY_COUNT(BYTES_ALLOCATED, N * sizeof(double));
 
     return FFT(p_coeffs);
 }
 
 Polynomial Polynomial::PolyMult(const Polynomial &p, const Polynomial &q,
                                 uint8_t pow1, uint8_t pow2) {
+    POLY_TIMER(MULT_NS);
+    POLY_COUNT(MULT_FFT, 1);
     uint32_t num_coeffs = pow1 * p.m_degree + pow2 * q.m_degree + 1;
-    uint32_t N = pow2_round(num_coeffs);
+    uint32_t N = smooth_round(num_coeffs);
 
     // Parallelize FFT computation on p and q
-    std::future<std::vector<cd>> f1 = std::async(PolyMultHelper, std::cref(p), N);
-    std::future<std::vector<cd>> f2 = std::async(PolyMultHelper, std::cref(q), N);
+    std::future<std::vector<cd>> f1 = Async(true, PolyMultHelper, std::cref(p), N);
+    std::future<std::vector<cd>> f2 = Async(true, PolyMultHelper, std::cref(q), N);
     f1.wait();
     f2.wait();
     std::vector<cd> pFFT = f1.get();
     std::vector<cd> qFFT = f2.get();
     
-    // Compute r = p^pow1 * q^pow2 on primitive N-th roots of unity
+    // Compute r = p^pow1 * q^pow2 on primitive N-th roots of unity.
+    // Integer powers by repeated multiplication: std::pow goes through exp and log, slowly and inexactly
+    auto ipow = [](cd x, uint8_t k) {
+        cd r = 1;
+        for (; k; k >>= 1) {
+            if (k & 1) {
+                r *= x;
+            }
+            x *= x;
+        }
+        return r;
+    };
     for (uint32_t i = 0; i < N; i++) {
-        pFFT[i] = std::pow(pFFT[i], pow1) * std::pow(qFFT[i], pow2);
+        pFFT[i] = ipow(pFFT[i], pow1) * ipow(qFFT[i], pow2);
     }
 
     // Use IFFT to recover product coeffs of r
@@ -101,6 +127,259 @@ Polynomial Polynomial::PolyMult(const Polynomial &p, const Polynomial &q,
     return Polynomial(out_real);
 }
 
+/*
+    Splits integer coefficients into balanced signed limbs of the given width:
+    c = sum_i limbs[i] * 2^(bits i) with every limb in [-2^(bits - 1), 2^(bits - 1)).
+*/
+static std::vector<std::vector<double>> SplitLimbs(const std::vector<double> &c, int bits) {
+    std::vector<int64_t> rest(c.begin(), c.end());
+    std::vector<std::vector<double>> limbs;
+    const int64_t base = int64_t(1) << bits;
+    const int64_t half = base >> 1;
+
+    bool more = true;
+    while (more) {
+        more = false;
+        std::vector<double> limb(c.size());
+        for (size_t i = 0; i < c.size(); i++) {
+            int64_t r = rest[i] & (base - 1);
+            if (r >= half) {
+                r -= base;
+            }
+            limb[i] = static_cast<double>(r);
+            rest[i] = (rest[i] - r) >> bits;
+            more |= rest[i] != 0;
+        }
+        limbs.push_back(std::move(limb));
+    }
+    return limbs;
+}
+
+static double Norm2(const std::vector<double> &c) {
+    double s = 0;
+    for (double x : c) {
+        s += x * x;
+    }
+    return std::sqrt(s);
+}
+
+Polynomial Polynomial::PolyMultExact(const Polynomial &p, const Polynomial &q) {
+    const double limit = std::ldexp(1.0, 62);
+    auto integral = [limit](const Polynomial &x) {
+        return std::all_of(x.m_coeffs.begin(), x.m_coeffs.end(),
+                           [limit](double c) { return c == std::round(c) && std::abs(c) < limit; });
+    };
+    if (!integral(p) || !integral(q)) {
+        return PolyMult(p, q);
+    }
+
+    const uint32_t num_coeffs = static_cast<uint32_t>(p.m_degree + q.m_degree + 1);
+    const uint32_t N = smooth_round(num_coeffs);
+
+    // Limb k of the product sums the limb products P_i Q_j over i + j = k, each with its own error.
+    // Try whole coefficients first (bits = 0), then the widest limbs that pass.
+    std::vector<std::vector<double>> P, Q;
+    std::vector<double> bounds;
+    int bits = 0;
+    for (;;) {
+        P = bits ? SplitLimbs(p.m_coeffs, bits) : std::vector<std::vector<double>>{ p.m_coeffs };
+        Q = bits ? SplitLimbs(q.m_coeffs, bits) : std::vector<std::vector<double>>{ q.m_coeffs };
+        std::vector<double> np(P.size()), nq(Q.size());
+        std::transform(P.begin(), P.end(), np.begin(), Norm2);
+        std::transform(Q.begin(), Q.end(), nq.begin(), Norm2);
+
+        bounds.assign(P.size() + Q.size() - 1, 0);
+        for (size_t i = 0; i < P.size(); i++) {
+            for (size_t j = 0; j < Q.size(); j++) {
+                bounds[i + j] += np[i] * nq[j];
+            }
+        }
+        double worst = *std::max_element(bounds.begin(), bounds.end());
+        if (fft_error_bound(worst, 1, N) < 0.5 || bits == 1) {
+            break;
+        }
+        bits = bits ? bits - 1 : 21;
+    }
+
+    if (P.size() == 1 && Q.size() == 1) {
+        POLY_COUNT(MULT_FFT, 1);
+    }
+    else {
+        POLY_COUNT(MULT_SPLIT, 1);
+    }
+
+    // One forward transform per limb, then one inverse transform per limb of the product
+    std::vector<std::vector<cd>> spectra(P.size() + Q.size());
+    ParallelFor(spectra.size(), [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            std::vector<double> padded(t < P.size() ? P[t] : Q[t - P.size()]);
+            padded.resize(N, 0);
+            spectra[t] = FFT(padded);
+        }
+    });
+
+    std::vector<std::vector<double>> R(bounds.size());
+    ParallelFor(R.size(), [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) {
+            std::vector<cd> S(N, 0);
+            for (size_t i = 0; i < P.size(); i++) {
+                if (k >= i && k - i < Q.size()) {
+                    const std::vector<cd> &A = spectra[i];
+                    const std::vector<cd> &B = spectra[P.size() + k - i];
+                    for (uint32_t m = 0; m < N; m++) {
+                        S[m] += A[m] * B[m];
+                    }
+                }
+            }
+            std::vector<cd> r = InverseFFT(S);
+            R[k].resize(num_coeffs);
+            for (uint32_t m = 0; m < num_coeffs; m++) {
+                R[k][m] = std::round(std::real(r[m]));
+            }
+        }
+    });
+
+    // Recombine in integers when the bound on the result allows, so it is rounded only once
+    double magnitude = 0;
+    for (size_t k = 0; k < bounds.size(); k++) {
+        magnitude += std::ldexp(bounds[k], static_cast<int>(bits * k));
+    }
+    std::vector<double> result(num_coeffs);
+    if (magnitude < limit) {
+        for (uint32_t m = 0; m < num_coeffs; m++) {
+            int64_t s = 0;
+            for (size_t k = 0; k < R.size(); k++) {
+                s += static_cast<int64_t>(std::ldexp(R[k][m], static_cast<int>(bits * k)));
+            }
+            result[m] = static_cast<double>(s);
+        }
+    }
+    else {
+        for (uint32_t m = 0; m < num_coeffs; m++) {
+            long double s = 0;
+            for (size_t k = 0; k < R.size(); k++) {
+                s += std::ldexp(static_cast<long double>(R[k][m]), static_cast<int>(bits * k));
+            }
+            result[m] = static_cast<double>(s);
+        }
+    }
+    return Polynomial(result);
+}
+
+Polynomial::ProductNode Polynomial::ProductTreeMult(const ProductNode &a, const ProductNode &b, bool integral) {
+    uint32_t num_coeffs = a.coeffs.size() + b.coeffs.size() - 1;
+    ProductNode r;
+
+    if (std::min(a.coeffs.size(), b.coeffs.size()) <= 32) {
+        POLY_COUNT(MULT_SCHOOLBOOK, 1);
+        r.coeffs.assign(num_coeffs, 0);
+        for (size_t i = 0; i < a.coeffs.size(); i++) {
+            for (size_t j = 0; j < b.coeffs.size(); j++) {
+                r.coeffs[i + j] += a.coeffs[i] * b.coeffs[j];
+            }
+        }
+        return r;
+    }
+
+    POLY_COUNT(MULT_FFT, 1);
+    // A child transformed at half the length only needs its odd bins computed, 
+    // which is worth a little extra padding
+    uint32_t N = smooth_round(num_coeffs);
+    for (uint32_t h : { static_cast<uint32_t>(a.spectrum.size()), static_cast<uint32_t>(b.spectrum.size()) }) {
+        if (h > 0 && 2 * h >= num_coeffs && 2 * h <= pow2_round(num_coeffs)) {
+            N = 2 * h;
+            break;
+        }
+    }
+    auto transform = [N](const ProductNode &x) {
+        uint32_t h = N >> 1;
+        if (x.spectrum.size() != h) {
+            std::vector<double> padded(x.coeffs);
+            padded.resize(N, 0);
+            return FFT(padded);
+        }
+
+        // The even-indexed values at N points are the values at N/2 points; 
+        // the odd-indexed ones are the N/2 point transform of x_k * w^k, w = e^{-2 pi i / N}
+        std::vector<cd> twisted(h, 0);
+        for (uint32_t k = 0; k < x.coeffs.size(); k++) {
+            twisted[k] = x.coeffs[k] * cd(std::cos(-TAU * k / N), std::sin(-TAU * k / N));
+        }
+        std::vector<cd> odd = FFT(twisted);
+        std::vector<cd> X(N);
+        for (uint32_t k = 0; k < h; k++) {
+            X[2 * k] = x.spectrum[k];
+            X[2 * k + 1] = odd[k];
+        }
+        return X;
+    };
+
+    std::future<std::vector<cd>> f = Async(true, transform, std::cref(b));
+    r.spectrum = transform(a);
+    std::vector<cd> bFFT = f.get();
+    for (uint32_t i = 0; i < N; i++) {
+        r.spectrum[i] *= bFFT[i];
+    }
+
+    std::vector<cd> out = InverseFFT(r.spectrum);
+    r.coeffs.resize(num_coeffs);
+    std::transform(out.begin(),
+                   out.begin() + num_coeffs,
+                   r.coeffs.begin(),
+                   [integral](cd x) { return integral ? roundError(std::real(x)) : std::real(x); });
+    return r;
+}
+
+Polynomial Polynomial::ProductTree(std::vector<ProductNode> &nodes) {
+    if (nodes.empty()) {
+        return Polynomial({ 1 });
+    }
+
+    bool integral = std::all_of(nodes.begin(), nodes.end(), [](const ProductNode &x) {
+        return std::all_of(x.coeffs.begin(), x.coeffs.end(), [](double c) { return c == std::round(c); });
+    });
+    while (nodes.size() > 1) {
+        std::stable_sort(nodes.begin(), nodes.end(), [](const ProductNode &x, const ProductNode &y) {
+            return x.coeffs.size() < y.coeffs.size();
+        });
+
+        size_t pairs = nodes.size() / 2;
+        std::vector<ProductNode> next(pairs);
+        ParallelFor(pairs, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                next[i] = ProductTreeMult(nodes[2 * i], nodes[2 * i + 1], integral);
+            }
+        });
+
+        if (nodes.size() & 1) {
+            next.push_back(std::move(nodes.back()));
+        }
+        nodes = std::move(next);
+    }
+
+    return Polynomial(nodes[0].coeffs);
+}
+
+Polynomial Polynomial::PolyProduct(const std::vector<Polynomial> &polys) {
+    std::vector<ProductNode> nodes(polys.size());
+    for (size_t i = 0; i < polys.size(); i++) {
+        nodes[i].coeffs = polys[i].m_coeffs;
+    }
+    return ProductTree(nodes);
+}
+
+Polynomial Polynomial::PolyFromRoots(const std::vector<double> &roots) {
+    // Leaves are the quadratics (x - r_i)(x - r_j), expanded directly
+    std::vector<ProductNode> nodes((roots.size() + 1) / 2);
+    for (size_t i = 0; i + 1 < roots.size(); i += 2) {
+        nodes[i / 2].coeffs = { roots[i] * roots[i + 1], -(roots[i] + roots[i + 1]), 1 };
+    }
+    if (roots.size() & 1) {
+        nodes.back().coeffs = { -roots.back(), 1 };
+    }
+    return ProductTree(nodes);
+}
+
 Polynomial Polynomial::PolyInverse(const Polynomial &p, uint32_t t) {
     if (p[0] == 0) {
         throw std::invalid_argument("Inverse does not exist");
@@ -118,6 +397,532 @@ Polynomial Polynomial::PolyInverse(const Polynomial &p, uint32_t t) {
     return inv;
 }
 
+Polynomial Polynomial::Truncate(const Polynomial &p, uint32_t n) {
+    if (p.m_degree < n) {
+        return p;
+    }
+    return Polynomial(std::vector<double>(p.m_coeffs.begin(), p.m_coeffs.begin() + n));
+}
+
+Polynomial Polynomial::SeriesMult(const Polynomial &p, const Polynomial &q, uint32_t n) {
+    uint32_t pn = std::min<size_t>(p.m_degree + 1, n);
+    uint32_t qn = std::min<size_t>(q.m_degree + 1, n);
+    uint32_t num_coeffs = std::min(pn + qn - 1, n);
+
+    if (std::min(pn, qn) <= 32) {
+        POLY_COUNT(MULT_SCHOOLBOOK, 1);
+        std::vector<double> result(num_coeffs, 0);
+        for (uint32_t i = 0; i < pn; i++) {
+            for (uint32_t j = 0; j < qn && i + j < num_coeffs; j++) {
+                result[i + j] += p[i] * q[j];
+            }
+        }
+        return Polynomial(result);
+    }
+
+    POLY_COUNT(MULT_FFT, 1);
+    uint32_t N = smooth_round(pn + qn - 1);
+    std::future<std::vector<cd>> f = Async(true, PolyMultHelper, Truncate(q, qn), N);
+    std::vector<cd> pFFT = PolyMultHelper(Truncate(p, pn), N);
+    std::vector<cd> qFFT = f.get();
+    for (uint32_t i = 0; i < N; i++) {
+        pFFT[i] *= qFFT[i];
+    }
+
+    std::vector<cd> out = InverseFFT(pFFT);
+    std::vector<double> result(num_coeffs);
+    std::transform(out.begin(),
+                   out.begin() + num_coeffs,
+                   result.begin(),
+                   [](cd x) { return std::real(x); });
+    return Polynomial(result);
+}
+
+Polynomial Polynomial::SeriesMult(const Polynomial &p, const Polynomial &q, uint32_t n, bool exact) {
+    // The schoolbook method only rounds sums past 2^53
+    if (!exact || std::min<size_t>(std::min(p.m_degree, q.m_degree) + 1, n) <= 32) {
+        return SeriesMult(p, q, n);
+    }
+    return Truncate(PolyMultExact(Truncate(p, n), Truncate(q, n)), n);
+}
+
+Polynomial Polynomial::SeriesInverse(const Polynomial &p, uint32_t n) {
+    if (p[0] == 0) {
+        throw std::invalid_argument("Inverse does not exist");
+    }
+
+    uint32_t m = 1;
+    Polynomial inv = Polynomial({ 1 / p[0] });
+    while (m < n) {
+        m <<= 1;
+        // inv = 2 * inv - inv * (A * inv)
+        inv = (inv * 2) - SeriesMult(inv, SeriesMult(p, inv, m), m);
+    }
+    return Truncate(inv, n);
+}
+
+Polynomial Polynomial::PolyLog(const Polynomial &p, uint32_t n) {
+    if (p[0] <= 0) {
+        throw std::invalid_argument("Logarithm requires p(0) > 0");
+    }
+
+    Polynomial head = Truncate(p, n);
+    Polynomial ratio = SeriesMult(PolyDerivative(head), SeriesInverse(head, n), n - 1);
+    Polynomial log = Truncate(PolyAntiDerivative(ratio), n);
+    log.m_coeffs[0] = std::log(p[0]);
+    return log;
+}
+
+Polynomial Polynomial::PolyExp(const Polynomial &p, uint32_t n) {
+    // exp(p) = e^{p(0)} exp(p - p(0)), and the Newton iteration needs a series with no constant term
+    Polynomial head = Truncate(p, n);
+    double scale = std::exp(head[0]);
+    head.m_coeffs[0] = 0;
+
+    uint32_t m = 1;
+    Polynomial e = Polynomial({ 1 });
+    while (m < n) {
+        m <<= 1;
+        Polynomial step = Polynomial({ 1 }) + Truncate(head, m) - PolyLog(e, m);
+        e = SeriesMult(e, step, m);
+    }
+    return Truncate(e, n) * scale;
+}
+
+Polynomial Polynomial::PolyPow(const Polynomial &p, uint64_t k, uint32_t n) {
+    if (n == 0) {
+        return Polynomial({ 0 });
+    }
+    if (k == 0) {
+        return Polynomial({ 1 });
+    }
+
+    uint32_t t = 0;
+    while (t <= p.m_degree && p[t] == 0) {
+        t++;
+    }
+    if (t > p.m_degree) {
+        return Polynomial({ 0 });
+    }
+
+    // p^k has only k deg(p) + 1 terms
+    if (p.m_degree == 0 || k <= n / p.m_degree) {
+        n = static_cast<uint32_t>(std::min<uint64_t>(n, k * p.m_degree + 1));
+    }
+    if (t > 0 && k >= (n + t - 1) / t) {
+        return Polynomial({ 0 });
+    }
+
+    bool integral = std::all_of(p.m_coeffs.begin(), p.m_coeffs.end(), [](double x) { return x == std::round(x); });
+    if (integral || k < (1 << 16)) {
+        // Truncated binary powering. Integer powers stay exact as long as PolyMultExact can keep them so.
+        auto mult = [integral, n](const Polynomial &a, const Polynomial &b) {
+            return integral ? Truncate(PolyMultExact(a, b), n) : SeriesMult(a, b, n);
+        };
+        Polynomial base = Truncate(p, n);
+        Polynomial result = Polynomial({ 1 });
+        for (;;) {
+            if (k & 1) {
+                result = mult(result, base);
+            }
+            k >>= 1;
+            if (k == 0) {
+                return result;
+            }
+            base = mult(base, base);
+        }
+    }
+
+    // p = c x^t (1 + q), so p^k = c^k x^{tk} exp(k log(1 + q))
+    uint32_t shift = t * k;
+    uint32_t m = n - shift;
+    double c = p[t];
+    std::vector<double> unit(std::min<size_t>(p.m_degree + 1 - t, m));
+    for (uint32_t i = 0; i < unit.size(); i++) {
+        unit[i] = p[t + i] / c;
+    }
+
+    Polynomial e = PolyExp(PolyLog(Polynomial(unit), m) * static_cast<double>(k), m);
+    std::vector<double> result(shift, 0);
+    double ck = std::pow(c, static_cast<double>(k));
+    for (uint32_t i = 0; i <= e.m_degree; i++) {
+        result.push_back(ck * e[i]);
+    }
+    return Polynomial(result);
+}
+
+Polynomial Polynomial::ComposeRange(const std::vector<double> &f, size_t lo, size_t len, 
+                                    const std::vector<Polynomial> &hpow, size_t v, uint32_t n, bool exact) {
+    // h^k x^{vk} * a mod x^n: only the first n - vk terms of h^k a survive the shift,
+    // and the coefficients below x^{vk} stay exact
+    auto times_power = [&hpow, v, n, exact](const Polynomial &a, size_t j) {
+        uint64_t shift = static_cast<uint64_t>(v) << j;
+        if (shift >= n) {
+            return Polynomial({ 0 });
+        }
+        Polynomial prod = SeriesMult(a, hpow[j], static_cast<uint32_t>(n - shift), exact);
+        std::vector<double> coeffs(shift, 0);
+        coeffs.insert(coeffs.end(), prod.m_coeffs.begin(), prod.m_coeffs.end());
+        return Polynomial(coeffs);
+    };
+
+    if (len <= 8) {
+        // Horner's method on the short range
+        Polynomial r = Polynomial({ f[lo + len - 1] });
+        for (size_t i = len - 1; i > 0; i--) {
+            r = times_power(r, 0) + Polynomial({ f[lo + i - 1] });
+        }
+        return r;
+    }
+
+    // f_lo(g) + g^half * f_hi(g), with half the largest power of 2 below len
+    size_t j = 0;
+    while ((size_t(2) << j) < len) {
+        j++;
+    }
+    size_t half = size_t(1) << j;
+
+    // g^half = O(x^{v half}), so f_hi(g) is only needed to n - v half terms
+    uint64_t shift = static_cast<uint64_t>(v) << j;
+    if (shift >= n) {
+        return ComposeRange(f, lo, half, hpow, v, n, exact);
+    }
+
+    // Short ranges are cheaper to run in sequence than on a new thread
+    std::future<Polynomial> hi = Async(len >= 256,
+                                       ComposeRange, std::cref(f), lo + half, len - half, 
+                                       std::cref(hpow), v, static_cast<uint32_t>(n - shift), exact);
+    Polynomial low = ComposeRange(f, lo, half, hpow, v, n, exact);
+    return low + times_power(hi.get(), j);
+}
+
+Polynomial Polynomial::ComposeBabyGiant(const std::vector<double> &f, const Polynomial &h, size_t v, uint32_t n, 
+                                        size_t k, bool exact) {
+    // Baby steps g^j = x^{vj} h^j for j <= k, kept without the shift to the n - vj terms that survive it
+    std::vector<Polynomial> hpow(1, Polynomial({ 1 }));
+    for (size_t j = 1; j <= k && static_cast<uint64_t>(v) * j < n; j++) {
+        hpow.push_back(SeriesMult(hpow.back(), h, static_cast<uint32_t>(n - v * j), exact));
+    }
+
+    // The inner sums B_i = sum_{j < k} f_{ik+j} g^j mod x^len are a dense matrix product, 
+    // split by coefficient so every thread streams over all the baby steps
+    auto block = [&f, &hpow, v, k](size_t i, size_t len) {
+        std::vector<double> b(len, 0);
+        ParallelFor(len, [&](size_t begin, size_t end) {
+            for (size_t j = 0; j < k && j < hpow.size() && i * k + j < f.size(); j++) {
+                const double c = f[i * k + j];
+                if (c == 0) {
+                    continue;
+                }
+                const size_t shift = v * j;
+                const size_t top = std::min(end, shift + hpow[j].m_degree + 1);
+                for (size_t t = std::max(begin, shift); t < top; t++) {
+                    b[t] += c * hpow[j].m_coeffs[t - shift];
+                }
+            }
+        }, 4096);
+        return Polynomial(b);
+    };
+
+    // Giant steps: Horner's method in g^k = x^{vk} h^k, which leaves only the n - vk terms of 
+    // the running sum that survive the shift
+    const size_t blocks = (f.size() + k - 1) / k;
+    const uint64_t shift = static_cast<uint64_t>(v) * k;
+    if (blocks == 1 || shift >= n) {
+        return block(0, n);
+    }
+    const uint32_t m = static_cast<uint32_t>(n - shift);
+    Polynomial r = block(blocks - 1, m);
+    for (size_t i = blocks - 1; i > 0; i--) {
+        Polynomial prod = SeriesMult(r, hpow[k], m, exact);
+        std::vector<double> coeffs(shift, 0);
+        coeffs.insert(coeffs.end(), prod.m_coeffs.begin(), prod.m_coeffs.end());
+        r = Polynomial(coeffs) + block(i - 1, i > 1 ? m : n);
+    }
+    return r;
+}
+
+Polynomial Polynomial::PolyCompose(const Polynomial &f, const Polynomial &g, uint32_t n) {
+    if (n == 0) {
+        return Polynomial({ 0 });
+    }
+
+    // g = x^v h with h(0) != 0
+    size_t v = 0;
+    while (v <= g.m_degree && g[v] == 0) {
+        v++;
+    }
+    if (v > g.m_degree || v >= n) {
+        return Polynomial({ f[0] });
+    }
+
+    // When v > 0, the terms of f past x^{(n - 1) / v} vanish mod x^n
+    size_t fdeg = f.m_degree;
+    if (v > 0) {
+        fdeg = std::min<size_t>(fdeg, (n - 1) / v);
+    }
+    std::vector<double> fc(f.m_coeffs.begin(), f.m_coeffs.begin() + fdeg + 1);
+
+    // Substitute x = s y with the largest s <= 1 for which sum_{k > 0} |g_k| s^k <= max(1, |g_0|),
+    // which bounds every coefficient of every power of the scaled g by max(2, 2 |g_0|)^i
+    const double budget = std::max(1.0, std::abs(g[0]));
+    const size_t terms = std::min<size_t>(g.m_degree + 1, n);
+    auto tail = [&g, terms](double s) {
+        double sum = 0;
+        double sk = 1;
+        for (size_t k = 1; k < terms; k++) {
+            sk *= s;
+            sum += std::abs(g[k]) * sk;
+        }
+        return sum;
+    };
+    double s = 1;
+    while (tail(s) > budget && s > 1e-300) {
+        s /= 2;
+    }
+    if (s < 1) {
+        double hi = 2 * s;
+        for (int i = 0; i < 32; i++) {
+            double mid = (s + hi) / 2;
+            if (tail(mid) > budget) {
+                hi = mid;
+            }
+            else {
+                s = mid;
+            }
+        }
+    }
+
+    std::vector<double> hc(terms - v);
+    for (size_t k = v; k < terms; k++) {
+        hc[k - v] = s < 1 ? g[k] * std::pow(s, static_cast<double>(k)) : g[k];
+    }
+
+    // Integer compositions that need no scaling stay exact as long as PolyMultExact can keep them so
+    auto is_integer = [](double x) { return x == std::round(x); };
+    const bool exact = s == 1 && std::all_of(fc.begin(), fc.end(), is_integer) && 
+                       std::all_of(hc.begin(), hc.end(), is_integer);
+
+    // Divide and conquer multiplies each range of f by a power of g, and those products stop growing 
+    // at n terms, which suits a short g. Baby-step giant-step multiplies by about 2 sqrt(deg f) powers 
+    // of g and adds up deg f n terms, which suits a long one. Both are estimated in coefficients of 
+    // an FFT product times its stages.
+    const double d = static_cast<double>(hc.size() - 1);
+    auto mult = [n](double a, double b) {
+        double t = std::min<double>(n, a + b - 1);
+        return std::min(a, b) <= 32 ? a * b * MULTIPLY_ADD_COST : t * std::log2(2 * t);
+    };
+    auto power_terms = [n, d](double i) { return std::min<double>(n, i * d + 1); };
+    double split = 0;
+    for (size_t len = 1; len < fc.size(); len <<= 1) {
+        split += fc.size() / (2.0 * len) * mult(power_terms(len), power_terms(len));
+    }
+    size_t steps = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(fc.size()))));
+    steps = std::max<size_t>(1, std::min<size_t>(steps, MAX_BABY_STEP_TERMS / n));
+    const size_t blocks = (fc.size() + steps - 1) / steps;
+    double baby = (blocks - 1) * mult(n, power_terms(steps));
+    for (size_t j = 1; j <= steps; j++) {
+        baby += mult(power_terms(j - 1), d + 1) + blocks * power_terms(j - 1) * MULTIPLY_ADD_COST;
+    }
+
+    Polynomial r({ 0 });
+    if (baby < split) {
+        r = ComposeBabyGiant(fc, Polynomial(hc), v, n, steps, exact);
+    }
+    else {
+        std::vector<Polynomial> hpow;
+        hpow.push_back(Polynomial(hc));
+        for (size_t len = 2; len < fc.size(); len <<= 1) {
+            hpow.push_back(SeriesMult(hpow.back(), hpow.back(), n, exact));
+        }
+        r = ComposeRange(fc, 0, fc.size(), hpow, v, n, exact);
+    }
+
+    // Undo the substitution: coefficient k of the result was scaled by s^k
+    for (size_t k = 0; k <= r.m_degree; k++) {
+        if (s < 1 && r.m_coeffs[k] != 0) {
+            r.m_coeffs[k] *= std::pow(s, -static_cast<double>(k));
+        }
+        if (!std::isfinite(r.m_coeffs[k])) {
+            throw std::overflow_error("Composition overflows double precision");
+        }
+    }
+    return r;
+}
+
+std::pair<Polynomial, Polynomial> Polynomial::SeriesDiv(const Polynomial &f, const Polynomial &g) {
+    if (f.m_degree < g.m_degree) {
+        return PolyPair(Polynomial({ 0 }), f);
+    }
+
+    uint32_t N = f.m_degree - g.m_degree + 1;
+    Polynomial qR = SeriesMult(ReversePolynomial(f), SeriesInverse(ReversePolynomial(g), N), N);
+    std::vector<double> q(N, 0);
+    for (uint32_t i = 0; i <= qR.m_degree; i++) {
+        q[N - 1 - i] = qR[i];
+    }
+
+    Polynomial quotient = Polynomial(q);
+    Polynomial prod = SeriesMult(quotient, g, g.m_degree);
+    std::vector<double> r(std::max<size_t>(g.m_degree, 1), 0);
+    for (uint32_t i = 0; i < g.m_degree; i++) {
+        r[i] = f[i] - (i <= prod.m_degree ? prod[i] : 0);
+    }
+    return PolyPair(quotient, Polynomial(r));
+}
+
+Polynomial Polynomial::PolyShift(const Polynomial &p, double c) {
+    return PolyAffine(p, 1, c);
+}
+
+Polynomial Polynomial::PolyAffine(const Polynomial &p, double a, double c) {
+    // PolyCompose would scale c + ax by inexact powers of 1 / a, so integer inputs are shifted first,
+    // p(ax + c) = q(ax) with q(x) = p(x + c), and scaled by exact powers of a
+    bool integral = (a == std::round(a)) && (c == std::round(c)) && 
+                    std::all_of(p.m_coeffs.begin(), p.m_coeffs.end(), [](double x) { return x == std::round(x); });
+    if (!integral || std::abs(a) <= 1) {
+        return PolyCompose(p, Polynomial({ c, a }), p.m_degree + 1);
+    }
+
+    Polynomial r = PolyCompose(p, Polynomial({ c, 1 }), p.m_degree + 1);
+    double ak = 1;
+    for (size_t k = 0; k <= r.m_degree; k++, ak *= a) {
+        if (r.m_coeffs[k] != 0) {
+            r.m_coeffs[k] *= ak;
+        }
+        if (!std::isfinite(r.m_coeffs[k])) {
+            throw std::overflow_error("Affine substitution overflows double precision");
+        }
+    }
+    return r;
+}
+
+std::vector<Polynomial> Polynomial::PolyAffine(const std::vector<Polynomial> &polys, double a, double c) {
+    std::vector<Polynomial> result(polys.size(), Polynomial({ 0 }));
+    ParallelFor(polys.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            result[i] = PolyAffine(polys[i], a, c);
+        }
+    });
+    return result;
+}
+
+Polynomial Polynomial::NodeTree(const std::vector<double> &nodes, size_t lo, size_t len, 
+                                std::vector<Polynomial> &tree, size_t idx) {
+    Polynomial prod = Polynomial({ 1 });
+    if (len <= 32) {
+        // The conversions never read the products that contain the last node, which may be missing
+        for (size_t k = 0; k < len && lo + k < nodes.size(); k++) {
+            prod = SeriesMult(prod, Polynomial({ -nodes[lo + k], 1 }), k + 2);
+        }
+    }
+    else {
+        size_t half = len / 2;
+        std::future<Polynomial> right = Async(len >= 1024,
+                                              NodeTree, std::cref(nodes), lo + half, len - half, 
+                                              std::ref(tree), 2 * idx + 2);
+        Polynomial left = NodeTree(nodes, lo, half, tree, 2 * idx + 1);
+        prod = SeriesMult(left, right.get(), len + 1);
+    }
+    tree[idx] = Polynomial(prod.m_coeffs);
+    return prod;
+}
+
+Polynomial Polynomial::FromNewtonRange(const std::vector<double> &coeffs, const std::vector<double> &nodes, 
+                                       size_t lo, size_t len, const std::vector<Polynomial> &tree, size_t idx) {
+    if (len <= 32) {
+        // Horner's method in the Newton basis
+        Polynomial r = Polynomial({ coeffs[lo + len - 1] });
+        for (size_t k = len - 1; k > 0; k--) {
+            r = SeriesMult(r, Polynomial({ -nodes[lo + k - 1], 1 }), len - k + 1) + Polynomial({ coeffs[lo + k - 1] });
+        }
+        return r;
+    }
+
+    // c_lo + N_lo(x) * c_hi, where N_lo is the product over the nodes of the left half
+    size_t half = len / 2;
+    std::future<Polynomial> right = Async(len >= 1024,
+                                          FromNewtonRange, std::cref(coeffs), std::cref(nodes), 
+                                          lo + half, len - half, std::cref(tree), 2 * idx + 2);
+    Polynomial left = FromNewtonRange(coeffs, nodes, lo, half, tree, 2 * idx + 1);
+    return left + SeriesMult(tree[2 * idx + 1], right.get(), len);
+}
+
+void Polynomial::ToNewtonRange(const Polynomial &p, const std::vector<double> &nodes, size_t lo, size_t len, 
+                               const std::vector<Polynomial> &tree, size_t idx, std::vector<double> &out) {
+    // Division through the inverse of the reversed node product cancels badly in floating point,
+    // so the quadratic but stable synthetic division covers larger ranges than in the other conversions
+    if (len <= 128) {
+        // Synthetic division by (x - x_k) leaves p(x_k) as the remainder
+        std::vector<double> a(len, 0);
+        for (size_t i = 0; i < len && i <= p.m_degree; i++) {
+            a[i] = p[i];
+        }
+        for (size_t k = 0; k < len; k++) {
+            for (size_t i = len - 1; i > k; i--) {
+                a[i - 1] += nodes[lo + k] * a[i];
+            }
+            out[lo + k] = a[k];
+        }
+        return;
+    }
+
+    // p = Q * N_lo + R, where R holds the left half of the coefficients and Q the right half
+    size_t half = len / 2;
+    PolyPair qr = SeriesDiv(p, tree[2 * idx + 1]);
+    std::future<void> right = Async(len >= 1024,
+                                    ToNewtonRange, std::cref(qr.first), std::cref(nodes), 
+                                    lo + half, len - half, std::cref(tree), 2 * idx + 2, std::ref(out));
+    ToNewtonRange(qr.second, nodes, lo, half, tree, 2 * idx + 1, out);
+    right.get();
+}
+
+Polynomial Polynomial::PolyFromNewton(const std::vector<double> &coeffs, const std::vector<double> &nodes) {
+    if (coeffs.empty()) {
+        return Polynomial({ 0 });
+    }
+    if (nodes.size() + 1 < coeffs.size()) {
+        throw std::invalid_argument("Need at least one node per coefficient past the first");
+    }
+
+    std::vector<Polynomial> tree(4 * (coeffs.size() / 32 + 1), Polynomial({ 1 }));
+    NodeTree(nodes, 0, coeffs.size(), tree, 0);
+    return FromNewtonRange(coeffs, nodes, 0, coeffs.size(), tree, 0);
+}
+
+std::vector<double> Polynomial::PolyToNewton(const Polynomial &p, const std::vector<double> &nodes) {
+    size_t len = p.m_degree + 1;
+    if (nodes.size() + 1 < len) {
+        throw std::invalid_argument("Need at least one node per coefficient past the first");
+    }
+
+    std::vector<Polynomial> tree(4 * (len / 32 + 1), Polynomial({ 1 }));
+    std::vector<double> out(len);
+    NodeTree(nodes, 0, len, tree, 0);
+    ToNewtonRange(p, nodes, 0, len, tree, 0, out);
+    return out;
+}
+
+static std::vector<double> FallingNodes(size_t n) {
+    std::vector<double> nodes(n);
+    for (size_t i = 0; i < n; i++) {
+        nodes[i] = static_cast<double>(i);
+    }
+    return nodes;
+}
+
+Polynomial Polynomial::PolyFromFallingFactorial(const std::vector<double> &coeffs) {
+    Polynomial p = PolyFromNewton(coeffs, FallingNodes(coeffs.size()));
+    std::transform(p.m_coeffs.begin(), p.m_coeffs.end(), p.m_coeffs.begin(), roundError);
+    return p;
+}
+
+std::vector<double> Polynomial::PolyToFallingFactorial(const Polynomial &p) {
+    std::vector<double> coeffs = PolyToNewton(p, FallingNodes(p.m_degree + 1));
+    std::transform(coeffs.begin(), coeffs.end(), coeffs.begin(), roundError);
+    return coeffs;
+}
+
 Polynomial Polynomial::operator*(const double& d) const {
     if (d == 0) {
         return Polynomial({ 0 });
@@ -189,6 +994,10 @@ double Polynomial::operator[](const size_t &i) const {
     return m_coeffs[i];
 }
 
+size_t Polynomial::Degree() const {
+    return m_degree;
+}
+
 Polynomial::PolyPair Polynomial::PolyDiv(const Polynomial &f, const Polynomial &g) {
     uint32_t N = f.m_degree - g.m_degree + 1;
     Polynomial fR = ReversePolynomial(f);
@@ -299,11 +1108,219 @@ double Polynomial::NewtonsMethod(double guess,
         i++;
         x0 = x1;
     }
-    std::cout.precision(15);
-    std::cout << "After " << i << " iterations: " << x0 << std::endl;
+    POLY_COUNT(NEWTON_ITERATIONS, i);
     return x0;
 }
 
+std::vector<double> Polynomial::NewtonsMethod(const std::vector<double> &guesses,
+                                              double tolerance,
+                                              uint32_t max_iters) const {
+    Polynomial deriv = PolyDerivative(*this);
+    std::vector<double> roots(guesses);
+
+    ParallelFor(roots.size(), [&](size_t begin, size_t end) {
+        double x0, x1;
+        for (size_t k = begin; k < end; k++) {
+            x0 = roots[k];
+            for (uint32_t i = 0; i < max_iters; i++) {
+                x1 = x0 - PolyEval(x0) / deriv.PolyEval(x0);
+                if (std::abs(x1 - x0) < tolerance) {
+                    break;
+                }
+                x0 = x1;
+            }
+            roots[k] = x0;
+        }
+    }, 64);
+
+    return roots;
+}
+
+/*
+    Accumulates sum_{j in [begin, end)} 1 / (z - z_j) over split real/imaginary arrays.
+    Four independent partial sums keep the loop free of a serial dependency so it vectorizes.
+*/
+static void AberthSum(const double *re, const double *im, size_t begin, size_t end,
+                      double zr, double zi, double &sr, double &si) {
+    double r[4] = { 0, 0, 0, 0 };
+    double s[4] = { 0, 0, 0, 0 };
+    double dr, di, m;
+    size_t j = begin;
+    for (; j + 4 <= end; j += 4) {
+        for (size_t l = 0; l < 4; l++) {
+            dr = zr - re[j + l];
+            di = zi - im[j + l];
+            m = 1 / (dr * dr + di * di);
+            r[l] += dr * m;
+            s[l] -= di * m;
+        }
+    }
+    for (; j < end; j++) {
+        dr = zr - re[j];
+        di = zi - im[j];
+        m = 1 / (dr * dr + di * di);
+        r[0] += dr * m;
+        s[0] -= di * m;
+    }
+    sr += (r[0] + r[1]) + (r[2] + r[3]);
+    si += (s[0] + s[1]) + (s[2] + s[3]);
+}
+
+std::vector<cd> Polynomial::AberthSolve(double tolerance, uint32_t max_iters, bool parallel) const {
+    size_t n = m_degree;
+    while (n > 0 && m_coeffs[n] == 0) {
+        n--;
+    }
+    if (n == 0) {
+        return {};
+    }
+
+    // x = 0 is an exact root of multiplicity equal to the number of vanishing low-order coefficients
+    size_t zeros = 0;
+    while (m_coeffs[zeros] == 0) {
+        zeros++;
+    }
+    std::vector<cd> roots(zeros, cd(0, 0));
+    n -= zeros;
+    if (n == 0) {
+        return roots;
+    }
+
+    // Monic coefficients, and those of the reversed polynomial for evaluating at |z| > 1
+    std::vector<double> a(n + 1), rev(n + 1);
+    for (size_t k = 0; k <= n; k++) {
+        a[k] = m_coeffs[k + zeros] / m_coeffs[n + zeros];
+        rev[n - k] = a[k];
+    }
+
+    /*
+        Initial guesses from the upper convex hull of the points (k, log|a_k|) (Newton polygon):
+        an edge from k_i to k_j holds k_j - k_i roots of modulus about (|a_k_i| / |a_k_j|)^(1 / (k_j - k_i)).
+        Each group is spread on its circle, rotated off the real axis so conjugate pairs can separate.
+    */
+    std::vector<size_t> hull;
+    for (size_t k = 0; k <= n; k++) {
+        if (a[k] == 0) {
+            continue;
+        }
+        while (hull.size() >= 2) {
+            size_t i = hull[hull.size() - 2], j = hull.back();
+            double cross = (j - i) * (std::log(std::abs(a[k])) - std::log(std::abs(a[i]))) -
+                           (k - i) * (std::log(std::abs(a[j])) - std::log(std::abs(a[i])));
+            if (cross < 0) {
+                break;
+            }
+            hull.pop_back();
+        }
+        hull.push_back(k);
+    }
+
+    std::vector<double> re(n), im(n), nre(n), nim(n);
+    std::vector<uint8_t> done(n, 0);
+    size_t idx = 0;
+    for (size_t h = 0; h + 1 < hull.size(); h++) {
+        size_t m = hull[h + 1] - hull[h];
+        double radius = std::pow(std::abs(a[hull[h]] / a[hull[h + 1]]), 1.0 / m);
+        for (size_t i = 0; i < m; i++, idx++) {
+            re[idx] = radius * std::cos(TAU * i / m + TAU * h / n + 0.4);
+            im[idx] = radius * std::sin(TAU * i / m + TAU * h / n + 0.4);
+        }
+    }
+
+    const double eps = std::numeric_limits<double>::epsilon();
+    bool active = true;
+    std::function<void(size_t, size_t)> sweep = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            double zr = re[i], zi = im[i];
+            nre[i] = zr;
+            nim[i] = zi;
+            if (done[i]) {
+                continue;
+            }
+
+            // Newton correction p(z)/p'(z) via Horner, with a running bound on the rounding error
+            double mod = std::hypot(zr, zi);
+            bool inverted = mod > 1;
+            const std::vector<double> &c = inverted ? a : rev;
+            double xr = zr, xi = zi, xm = mod;
+            if (inverted) {
+                xr = zr / (mod * mod);
+                xi = -zi / (mod * mod);
+                xm = 1 / mod;
+            }
+            double pr = c[0], pi = 0, dr = 0, di = 0, err = std::abs(pr), t;
+            for (size_t k = 1; k <= n; k++) {
+                t = dr * xr - di * xi + pr;
+                di = dr * xi + di * xr + pi;
+                dr = t;
+                t = pr * xr - pi * xi + c[k];
+                pi = pr * xi + pi * xr;
+                pr = t;
+                err = err * xm + std::abs(c[k]);
+            }
+            if (std::hypot(pr, pi) <= 4 * eps * err) {
+                done[i] = 1;
+                continue;
+            }
+
+            cd ratio;
+            if (inverted) {
+                // p(z)/p'(z) = q(y) / (n y q(y) - y^2 q'(y)), where q is the reversal of p and y = 1/z
+                cd y(xr, xi), q(pr, pi), dq(dr, di);
+                ratio = q / (static_cast<double>(n) * y * q - y * y * dq);
+            }
+            else {
+                ratio = cd(pr, pi) / cd(dr, di);
+            }
+
+            double sr = 0, si = 0;
+            AberthSum(re.data(), im.data(), 0, i, zr, zi, sr, si);
+            AberthSum(re.data(), im.data(), i + 1, n, zr, zi, sr, si);
+            cd w = ratio / (1.0 - ratio * cd(sr, si));
+
+            nre[i] = zr - std::real(w);
+            nim[i] = zi - std::imag(w);
+            if (std::abs(w) <= tolerance * std::max(1.0, mod)) {
+                done[i] = 1;
+            }
+        }
+    };
+
+    for (uint32_t iter = 0; iter < max_iters && active; iter++) {
+        if (parallel) {
+            ParallelFor(n, sweep, 64);
+        }
+        else {
+            sweep(0, n);
+        }
+        std::swap(re, nre);
+        std::swap(im, nim);
+        active = std::find(done.begin(), done.end(), 0) != done.end();
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        roots.push_back(cd(re[i], im[i]));
+    }
+    return roots;
+}
+
+std::vector<cd> Polynomial::PolyRoots(double tolerance, uint32_t max_iters) const {
+    // Below this degree a sweep is too cheap to be worth splitting across threads
+    return AberthSolve(tolerance, max_iters, m_degree >= 512);
+}
+
+std::vector<std::vector<cd>> Polynomial::PolyRoots(const std::vector<Polynomial> &polys,
+                                                   double tolerance,
+                                                   uint32_t max_iters) {
+    std::vector<std::vector<cd>> roots(polys.size());
+    ParallelFor(polys.size(), [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) {
+            roots[k] = polys[k].AberthSolve(tolerance, max_iters, false);
+        }
+    });
+    return roots;
+}
+
 void Polynomial::Reverse() {
     std::reverse(std::begin(m_coeffs), std::end(m_coeffs));
     int i;
@@ -319,3 +1336,12 @@ void Polynomial::PolyPrint() const {
     }
     std::cout << m_coeffs[m_degree] << "x^" << m_degree << std::endl;
 }
+
+void Polynomial::PolySave(const std::string &path) const {
+    MappedPolynomial::Save(path, m_coeffs.data(), m_coeffs.size());
+}
+
+Polynomial Polynomial::PolyLoad(const std::string &path) {
+    MappedPolynomial mapped(path);
+    return Polynomial(std::vector<double>(mapped.data(), mapped.data() + mapped.size()));
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <iostream> // cout
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -44,6 +45,101 @@ private:
     /*! Reverses coefficients of the polynomial in-place */
     void Reverse();
 
+    /*!
+        \brief Aberth-Ehrlich iteration shared by both PolyRoots overloads
+        \param [in] tolerance the relative step size at which a root is considered converged
+        \param [in] max_iters the maximum number of sweeps over all roots
+        \param [in] parallel whether a sweep is split across threads
+        \return the complex roots of the polynomial
+    */
+    std::vector<cd> AberthSolve(double, uint32_t, bool) const;
+
+    /*!
+        A node of the product tree: its coefficients, and their transform when 
+        the node was produced by an FFT multiplication (empty otherwise).
+    */
+    struct ProductNode {
+        std::vector<double> coeffs;
+        std::vector<cd> spectrum;
+    };
+
+    /*!
+        \brief Multiplies two product tree nodes
+        \details Small operands use schoolbook multiplication. Otherwise, an operand whose
+        spectrum has half the required transform length supplies the even-indexed values
+        directly, so only its odd-indexed values are transformed. FFT products are rounded 
+        to integers only when integral is set.
+    */
+    static ProductNode ProductTreeMult(const ProductNode &, const ProductNode &, bool);
+
+    /*! Reduces the nodes to their product by repeatedly pairing nodes of closest degree */
+    static Polynomial ProductTree(std::vector<ProductNode> &);
+
+    /*! \return p mod \f$ x^n \f$ */
+    static Polynomial Truncate(const Polynomial &, uint32_t);
+
+    /*! 
+        \return the first n coefficients of p * q
+        \note Unlike PolyMult, the coefficients are not rounded to nearby integers, 
+        since power series are not expected to have integer coefficients
+    */
+    static Polynomial SeriesMult(const Polynomial &, const Polynomial &, uint32_t);
+
+    /*! SeriesMult, through PolyMultExact when exact is set and the product is too long for the schoolbook method */
+    static Polynomial SeriesMult(const Polynomial &, const Polynomial &, uint32_t, bool);
+
+    /*! The Newton iteration of PolyInverse, on the first n terms of p and without rounding */
+    static Polynomial SeriesInverse(const Polynomial &, uint32_t);
+
+    /*! PolyDiv without rounding the quotient to integers */
+    static std::pair<Polynomial, Polynomial> SeriesDiv(const Polynomial &, const Polynomial &);
+
+    /*!
+        \brief Builds the tree of node products used by the Newton basis conversions
+        \param [in] nodes the interpolation nodes
+        \param [in] lo the first node of the range
+        \param [in] len the number of nodes in the range
+        \param [out] tree the node products, with the children of index i at 2i + 1 and 2i + 2
+        \param [in] idx the index of the range in the tree
+        \return \f$ \prod_{k < len} (x - x_{lo+k}) \f$, skipping the nodes past the end of nodes
+    */
+    static Polynomial NodeTree(const std::vector<double> &, size_t, size_t, 
+                               std::vector<Polynomial> &, size_t);
+
+    /*! Converts the Newton coefficients lo, ..., lo + len - 1 to the monomial basis, splitting as in NodeTree */
+    static Polynomial FromNewtonRange(const std::vector<double> &, const std::vector<double> &,
+                                      size_t, size_t, const std::vector<Polynomial> &, size_t);
+
+    /*! Writes the Newton coefficients lo, ..., lo + len - 1 of p, of degree below len, to out */
+    static void ToNewtonRange(const Polynomial &, const std::vector<double> &, size_t, size_t, 
+                              const std::vector<Polynomial> &, size_t, std::vector<double> &);
+
+    /*!
+        \brief Divide and conquer composition of a range of coefficients, for \f$ g = x^v h \f$
+        \param [in] f the outer coefficients
+        \param [in] lo the first coefficient of the range
+        \param [in] len the number of coefficients in the range
+        \param [in] hpow the powers \f$ h^{2^j} \bmod x^n \f$
+        \param [in] v the number of leading zero coefficients of g
+        \param [in] n the number of terms to keep
+        \param [in] exact whether to multiply integers exactly
+        \return \f$ \sum_{i < len} f_{lo+i} g^i \bmod x^n \f$
+    */
+    static Polynomial ComposeRange(const std::vector<double> &, size_t, size_t, 
+                                   const std::vector<Polynomial> &, size_t, uint32_t, bool);
+
+    /*!
+        \brief Baby-step giant-step composition, for \f$ g = x^v h \f$
+        \param [in] f the outer coefficients
+        \param [in] h the inner polynomial without its leading zero coefficients
+        \param [in] v the number of leading zero coefficients of g
+        \param [in] n the number of terms to keep
+        \param [in] k the number of baby steps
+        \param [in] exact whether to multiply integers exactly
+        \return \f$ \sum_i f_i g^i \bmod x^n \f$
+    */
+    static Polynomial ComposeBabyGiant(const std::vector<double> &, const Polynomial &, size_t, uint32_t, size_t, bool);
+
 public:
     typedef std::pair<Polynomial, Polynomial> PolyPair;
 
@@ -56,7 +152,7 @@ public:
     Polynomial(const Polynomial &);
 
     /*! Move Constructor */
-    Polynomial(const Polynomial &&p) noexcept;
+    Polynomial(Polynomial &&p) noexcept;
 
     /*! 
         \brief Polynomial Multiplication via FFT
@@ -68,6 +164,46 @@ public:
     */
     static Polynomial PolyMult(const Polynomial &, const Polynomial &, 
                                 uint8_t pow1 = 1, uint8_t pow2 = 1);
+
+    /*!
+        \brief Polynomial multiplication that is exact for integer coefficients
+        \param [in] p
+        \param [in] q
+        \return the polynomial \f$ p(x) q(x) \f$
+
+        \details PolyMult rounds results within epsilon of an integer, which silently goes wrong
+        once large coefficients or degrees exhaust the precision of the FFT. This instead bounds
+        the error rigorously from the input norms and the transform length (see fft_error_bound).
+        If the bound is below 1/2, one FFT product rounded to integers is exact. Otherwise the 
+        coefficients are split into signed limbs of the widest size, at most 21 bits, for which every 
+        limb product passes the bound, and the limb products are recombined in integers.
+        Each limb costs one forward transform, and each limb of the product one inverse transform.
+
+        The result is exact whenever its coefficients are below \f$ 2^{53} \f$ in magnitude, and 
+        correctly rounded while they are below \f$ 2^{62} \f$.
+        Coefficients that are not integers, or not below \f$ 2^{62} \f$ in magnitude, fall back to PolyMult.
+    */
+    static Polynomial PolyMultExact(const Polynomial &, const Polynomial &);
+
+    /*!
+        \brief Product of many polynomials via a balanced product tree
+        \param [in] polys the factors
+        \return the polynomial \f$ \prod_i p_i(x) \f$, or 1 if polys is empty
+
+        \details Each level pairs the factors of closest degree, and the pairs of a level
+        are multiplied concurrently. Costs \f$ O(n \log^2 n) \f$ for a product of degree n, 
+        instead of the \f$ O(kn \log n) \f$ of k successive PolyMult calls.
+        Products of integer factors are rounded to integers as in PolyMult. Other products are not, 
+        since snapping a coefficient to a nearby integer is an error the later levels multiply.
+    */
+    static Polynomial PolyProduct(const std::vector<Polynomial> &);
+
+    /*!
+        \brief Builds the monic polynomial with the given roots
+        \param [in] roots the roots, repeated according to multiplicity
+        \return the polynomial \f$ \prod_i (x - r_i) \f$
+    */
+    static Polynomial PolyFromRoots(const std::vector<double> &);
     
     /*!
         \brief Compute inverse series of a polynomial
@@ -80,6 +216,155 @@ public:
     */
     static Polynomial PolyInverse(const Polynomial &, uint32_t);
 
+    /*!
+        \brief Power series logarithm
+        \param [in] p the series
+        \param [in] n the number of terms to compute
+        \return \f$ \log p(x) \bmod x^n \f$, computed as \f$ \log p(0) + \int p'/p \f$
+
+        \throw std::invalid_argument Occurs when p(0) <= 0
+    */
+    static Polynomial PolyLog(const Polynomial &, uint32_t);
+
+    /*!
+        \brief Power series exponential via Newton iteration \f$ e \leftarrow e(1 - \log e + p) \f$
+        \param [in] p the series
+        \param [in] n the number of terms to compute
+        \return \f$ \exp p(x) \bmod x^n \f$
+    */
+    static Polynomial PolyExp(const Polynomial &, uint32_t);
+
+    /*!
+        \brief Truncated power of a polynomial
+        \param [in] p the base
+        \param [in] k the exponent
+        \param [in] n the number of terms to compute
+        \return \f$ p(x)^k \bmod x^n \f$, or 0 when n = 0
+
+        \details n is first clamped to the \f$ k \deg p + 1 \f$ terms of the full power.
+        When the coefficients of p are integers, or \f$ k < 2^{16} \f$, uses binary powering with
+        truncated products in \f$ O(n \log n \log k) \f$. Integer powers are multiplied with PolyMultExact,
+        so they are exact while their coefficients stay below \f$ 2^{53} \f$, and rounded as PolyMult does beyond.
+        Otherwise, writing \f$ p = c x^t (1 + q) \f$, computes \f$ c^k x^{tk} \exp(k \log(1 + q)) \f$
+        in \f$ O(n \log n) \f$ regardless of k.
+        \warning The exp/log path is only accurate when the coefficients of \f$ \log(1 + q) \f$ decay,
+        i.e. when p has no roots near or inside the unit circle. Otherwise they grow k-fold
+        and the result can lose all precision or overflow.
+    */
+    static Polynomial PolyPow(const Polynomial &, uint64_t, uint32_t);
+
+    /*!
+        \brief Polynomial composition
+        \param [in] f the outer polynomial
+        \param [in] g the inner polynomial
+        \param [in] n the number of terms to compute
+        \return \f$ f(g(x)) \bmod x^n \f$, or 0 when n = 0
+
+        \details When \f$ \deg g \f$ is small, splits f in halves, \f$ f(g) = f_{lo}(g) + g^{k} f_{hi}(g) \f$, 
+        with every product truncated to n terms, which costs \f$ O(N \log^2 N) \f$ where 
+        \f$ N = \min(n, \deg f \deg g) \f$. Once the powers of g fill all n terms, that would cost 
+        \f$ O(n \deg f \log n) \f$, so it switches, by an estimate of both costs, to baby-step giant-step 
+        (Brent and Kung's algorithm 2.1): \f$ f(g) = \sum_i B_i(g) \, (g^k)^i \f$ with \f$ k = \lceil \sqrt{\deg f} \rceil \f$, 
+        each \f$ B_i(g) \f$ summed from \f$ g^j, j < k \f$, and the outer sum by Horner's method in \f$ g^k \f$.
+        That takes \f$ O(\sqrt{\deg f} \, n \log n) \f$ for the products and \f$ n \deg f \f$ multiply-adds for 
+        the sums, which are quadratic but stream through memory on all threads.
+        When \f$ g(0) = 0 \f$ the powers of g are shifted rather than multiplied into the low terms,
+        so the coefficient of \f$ x^0 \f$ is exactly f(0).
+
+        Powers of g can have coefficients far larger than the result, and FFT products spread their
+        rounding error to every coefficient. So g is first scaled to \f$ g(sx) \f$ with the largest 
+        \f$ s \leq 1 \f$ for which \f$ \sum_{k > 0} |g_k| s^k \leq \max(1, |g(0)|) \f$, which keeps every 
+        intermediate coefficient below \f$ \sum_i |f_i| \max(2, 2|g(0)|)^i \f$, and the result is scaled back.
+        When f and g have integer coefficients and g needs no scaling, products use PolyMultExact, so the
+        result is exact while every intermediate coefficient stays below \f$ 2^{53} \f$.
+        \warning Coefficient k carries an absolute error of about \f$ s^{-k} \f$ times machine epsilon times that
+        bound. The low coefficients are accurate, but when g has large coefficients, and f a high degree, 
+        the high coefficients can be dominated by rounding error even where their true values are small.
+        \throw std::overflow_error Occurs when a coefficient of the result, or its error, overflows double precision
+    */
+    static Polynomial PolyCompose(const Polynomial &, const Polynomial &, uint32_t);
+
+    /*!
+        \brief Taylor shift
+        \param [in] p the polynomial
+        \param [in] c the shift
+        \return the polynomial p(x + c)
+
+        \details Splits p in halves over precomputed \f$ (x + c)^{2^j} \f$, as in PolyCompose, 
+        in \f$ O(n \log^2 n) \f$ instead of the \f$ O(n^2) \f$ of repeated Horner steps.
+        Integer p and c give exact results while the coefficients of the powers, up to \f$ (1 + |c|)^n \f$, 
+        and of the result stay below \f$ 2^{53} \f$.
+        \warning As in PolyCompose, the error is normwise: each coefficient carries an absolute error of about
+        machine epsilon times \f$ \sum_i |p_i| (1 + |c|)^i \f$, which grows exponentially with the degree.
+        Coefficients much smaller than that, which include the leading one, are lost. A shift by c = 1 of
+        a random polynomial of degree 300 already returns garbage for its top coefficients.
+        \throw std::overflow_error Occurs when a coefficient of the result, or its error, overflows double precision
+    */
+    static Polynomial PolyShift(const Polynomial &, double);
+
+    /*!
+        \brief Affine substitution
+        \param [in] p the polynomial
+        \param [in] a the scale
+        \param [in] c the shift
+        \return the polynomial p(ax + c)
+
+        \details Integer p, a and c with \f$ |a| > 1 \f$ are shifted first, as by PolyShift, then scaled by exact powers 
+        of a, so they give exact results under the same conditions. Otherwise composes with c + ax directly.
+        \warning The error is normwise, as for PolyShift, with \f$ |c| + \min(|a|, \max(1, |c|)) \f$ in place of
+        \f$ 1 + |c| \f$, and is further multiplied by \f$ \max(1, |a| / \max(1, |c|))^k \f$ in coefficient k.
+        \throw std::overflow_error Occurs when a coefficient of the result, or its error, overflows double precision
+    */
+    static Polynomial PolyAffine(const Polynomial &, double, double);
+
+    /*!
+        \brief Batched PolyAffine. Polynomials are transformed concurrently.
+        \param [in] polys the polynomials
+        \param [in] a the scale
+        \param [in] c the shift
+        \return the polynomials \f$ p_i(ax + c) \f$, in the same order as the input
+        \warning Each result carries the error of PolyAffine on its own.
+        \throw std::overflow_error Occurs when any of the results overflows, as in PolyAffine
+    */
+    static std::vector<Polynomial> PolyAffine(const std::vector<Polynomial> &, double, double);
+
+    /*!
+        \brief Converts from the Newton basis to the monomial basis
+        \param [in] coeffs the coefficients \f$ c_k \f$ of \f$ p(x) = \sum_k c_k \prod_{j < k} (x - x_j) \f$
+        \param [in] nodes the nodes \f$ x_j \f$. At least coeffs.size() - 1 are needed.
+        \return the polynomial p
+
+        \details Uses a tree of node products in \f$ O(n \log^2 n) \f$.
+        \throw std::invalid_argument Occurs when there are too few nodes
+    */
+    static Polynomial PolyFromNewton(const std::vector<double> &, const std::vector<double> &);
+
+    /*!
+        \brief Converts from the monomial basis to the Newton basis
+        \param [in] p the polynomial
+        \param [in] nodes the nodes \f$ x_j \f$. At least deg(p) are needed.
+        \return the coefficients \f$ c_k \f$ such that \f$ p(x) = \sum_k c_k \prod_{j < k} (x - x_j) \f$
+
+        \details Divides by the node products of a tree from the top down in \f$ O(n \log^2 n) \f$.
+        \warning Like PolyDiv, the division loses accuracy in double precision as the degree grows.
+        \throw std::invalid_argument Occurs when there are too few nodes
+    */
+    static std::vector<double> PolyToNewton(const Polynomial &, const std::vector<double> &);
+
+    /*!
+        \brief Converts from the falling factorial basis to the monomial basis
+        \param [in] coeffs the coefficients \f$ b_k \f$ of \f$ p(x) = \sum_k b_k x(x-1) \cdots (x-k+1) \f$
+        \return the polynomial p
+    */
+    static Polynomial PolyFromFallingFactorial(const std::vector<double> &);
+
+    /*!
+        \brief Converts from the monomial basis to the falling factorial basis
+        \param [in] p the polynomial
+        \return the coefficients \f$ b_k \f$ such that \f$ p(x) = \sum_k b_k x(x-1) \cdots (x-k+1) \f$
+    */
+    static std::vector<double> PolyToFallingFactorial(const Polynomial &);
+
     /*! 
         \brief Polynomial division
 
@@ -134,6 +419,9 @@ public:
     /*! Polynomial coefficient indexing */
     double operator[](const size_t &i) const;
 
+    /*! \return the index of the last stored coefficient, which may be zero */
+    size_t Degree() const;
+
     /*! Move assignment operator */
     Polynomial &operator=(Polynomial &&other) noexcept;
 
@@ -149,6 +437,46 @@ public:
                          double tolerance = 1e-6, 
                          uint32_t max_iters = 1e3) const;
 
+    /*!
+       \brief Multi-start Newton's Method. Runs silently and in parallel over the guesses.
+       \param [in] guesses the initial guesses
+       \param [in] tolerance Optional. Default value: 1e-6
+       \param [in] max_iters Optional. Default value: 1000
+
+       \return the root calculated from each guess, in the same order as the guesses
+
+       \note The derivative is computed once and shared by every start.
+    */
+    std::vector<double> NewtonsMethod(const std::vector<double> &,
+                                      double tolerance = 1e-6,
+                                      uint32_t max_iters = 1e3) const;
+
+    /*!
+       \brief Finds all complex roots simultaneously using the Aberth-Ehrlich method.
+       \param [in] tolerance Optional. Relative step size at which a root stops iterating. Default value: 1e-12
+       \param [in] max_iters Optional. Default value: 500
+
+       \return the roots, repeated according to multiplicity
+
+       \details Every sweep updates each unconverged root \f$ z_i \f$ by 
+       \f$ w_i = \frac{p(z_i)/p'(z_i)}{1 - p(z_i)/p'(z_i) \sum_{j \neq i} (z_i - z_j)^{-1}} \f$.
+       Roots converge independently and are frozen once converged. 
+       Large degrees split each sweep across threads.
+    */
+    std::vector<cd> PolyRoots(double tolerance = 1e-12, uint32_t max_iters = 500) const;
+
+    /*!
+       \brief Batched PolyRoots. Polynomials are solved concurrently.
+       \param [in] polys the polynomials to solve
+       \param [in] tolerance Optional. Default value: 1e-12
+       \param [in] max_iters Optional. Default value: 500
+
+       \return the roots of each polynomial, in the same order as the input
+    */
+    static std::vector<std::vector<cd>> PolyRoots(const std::vector<Polynomial> &,
+                                                  double tolerance = 1e-12,
+                                                  uint32_t max_iters = 500);
+
     /*!
         \brief Horner's method to evaluate polynomial at a point.
 
@@ -173,5 +501,24 @@ public:
     /*! \brief Prints the polynomial to stdout */
     void PolyPrint() const;
 
+    /*!
+        \brief Writes the coefficients to a file in the binary format of MappedPolynomial
+        \param [in] path the file to create or overwrite
+
+        \throw std::runtime_error Occurs when the file cannot be written
+    */
+    void PolySave(const std::string &) const;
+
+    /*!
+        \brief Reads a polynomial written by PolySave or MappedPolynomial::Save
+        \param [in] path the file to read
+        \return the polynomial
+
+        \remark To work with the coefficients in place without reading them all into memory, use MappedPolynomial.
+
+        \throw std::runtime_error Occurs when the file cannot be read, or is not a polynomial file
+    */
+    static Polynomial PolyLoad(const std::string &);
+
 };
 
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "StreamConvolver.h"
+#include "Util.h"
+
+StreamConvolver::StreamConvolver(const std::vector<double> &kernel, uint32_t block_size) {
+    if (kernel.empty()) {
+        throw std::invalid_argument("Kernel must be non-empty");
+    }
+
+    m_kernel_size = static_cast<uint32_t>(kernel.size());
+    if (block_size == 0) {
+        block_size = std::max<uint32_t>(3 * m_kernel_size, 256);
+    }
+    m_fft_size = smooth_round(block_size + m_kernel_size - 1);
+    m_block_size = m_fft_size - m_kernel_size + 1;
+
+    std::vector<double> padded(kernel);
+    padded.resize(m_fft_size, 0);
+    m_kernel_spectrum = FFT(padded);
+
+    Reset();
+}
+
+uint32_t StreamConvolver::BlockSize() const {
+    return m_block_size;
+}
+
+uint32_t StreamConvolver::FFTSize() const {
+    return m_fft_size;
+}
+
+void StreamConvolver::Reset() {
+    m_buffer.assign(m_kernel_size - 1, 0);
+    m_fed = false;
+}
+
+std::vector<double> StreamConvolver::ConvolveBlocks(size_t blocks) const {
+    const uint32_t N = m_fft_size;
+    const uint32_t B = m_block_size;
+    const uint32_t offset = m_kernel_size - 1;
+    std::vector<double> out(blocks * B);
+
+    // Block i reads m_buffer[i * B, i * B + N). The kernel is real, so blocks 2j and 2j + 1
+    // go through one transform as the real and imaginary parts of the input.
+    size_t pairs = (blocks + 1) / 2;
+    ParallelFor(pairs, [&](size_t begin, size_t end) {
+        std::vector<cd> segment(N);
+        for (size_t j = begin; j < end; j++) {
+            const size_t b0 = 2 * j;
+            const size_t b1 = b0 + 1;
+            const double *x0 = m_buffer.data() + b0 * B;
+            const double *x1 = m_buffer.data() + b1 * B;
+            for (uint32_t k = 0; k < N; k++) {
+                segment[k] = cd(x0[k], b1 < blocks ? x1[k] : 0);
+            }
+
+            std::vector<cd> spectrum = FFT(segment);
+            for (uint32_t k = 0; k < N; k++) {
+                spectrum[k] *= m_kernel_spectrum[k];
+            }
+            std::vector<cd> y = InverseFFT(spectrum);
+
+            // The first kernel_size - 1 outputs of the circular convolution wrap around
+            for (uint32_t k = 0; k < B; k++) {
+                out[b0 * B + k] = std::real(y[offset + k]);
+            }
+            if (b1 < blocks) {
+                for (uint32_t k = 0; k < B; k++) {
+                    out[b1 * B + k] = std::imag(y[offset + k]);
+                }
+            }
+        }
+    });
+
+    return out;
+}
+
+std::vector<double> StreamConvolver::Process(const std::vector<double> &samples) {
+    m_buffer.insert(m_buffer.end(), samples.begin(), samples.end());
+    m_fed = m_fed || !samples.empty();
+
+    size_t blocks = (m_buffer.size() - (m_kernel_size - 1)) / m_block_size;
+    if (blocks == 0) {
+        return std::vector<double>();
+    }
+
+    std::vector<double> out = ConvolveBlocks(blocks);
+    m_buffer.erase(m_buffer.begin(), m_buffer.begin() + blocks * m_block_size);
+    return out;
+}
+
+std::vector<double> StreamConvolver::Flush() {
+    if (!m_fed) {
+        return std::vector<double>();
+    }
+
+    // Pad with zeros to push the tail of the convolution through, up to a whole number of blocks
+    size_t remaining = m_buffer.size();     // outputs still owed: held back samples + kernel_size - 1
+    size_t blocks = (remaining + m_block_size - 1) / m_block_size;
+    m_buffer.resize(blocks * m_block_size + m_kernel_size - 1, 0);
+
+    std::vector<double> out = ConvolveBlocks(blocks);
+    out.resize(remaining);
+    Reset();
+    return out;
+}
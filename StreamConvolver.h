@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Util.h"
+
+
+/*!
+    \class StreamConvolver
+
+    \brief Convolves a fixed kernel against an unbounded stream of samples,
+    block by block, using overlap-save.
+
+    \remark The output stream is the linear convolution of the kernel with everything passed
+    to Process so far, i.e. the coefficients of Polynomial::PolyMult(kernel, input) without rounding.
+    Each call to Process emits the outputs of every block of input completed by that call;
+    at most BlockSize() - 1 samples are held back until the next call or Flush.
+
+    \remark The kernel's transform is computed once. Each block costs one transform and one
+    inverse transform of length FFTSize(), shared between two blocks by packing them into the
+    real and imaginary parts, and the blocks of a call are spread across threads with ParallelFor.
+    Memory use is bounded by the kernel, one block of history, and one transform per thread.
+*/
+class StreamConvolver
+{
+private:
+    uint32_t m_kernel_size;
+    uint32_t m_block_size;
+    uint32_t m_fft_size;
+    std::vector<cd> m_kernel_spectrum;
+
+    /*! The last m_kernel_size - 1 consumed samples followed by the samples of the unfinished block */
+    std::vector<double> m_buffer;
+
+    /*! Whether any samples were fed since the stream started, so that Flush owes a tail */
+    bool m_fed;
+
+    /*!
+        \brief Convolves the first blocks of m_buffer with the kernel
+        \param [in] blocks the number of complete blocks at the front of m_buffer to process
+        \return the blocks * m_block_size outputs of those blocks
+    */
+    std::vector<double> ConvolveBlocks(size_t blocks) const;
+
+public:
+    /*!
+        \brief Constructor
+        \param [in] kernel the filter coefficients. Must be non-empty.
+        \param [in] block_size the minimum number of new samples per block. Optional.
+        The block is grown so that the transform has a smooth length (see smooth_round).
+        By default it is a few times the kernel size, which balances latency against work per sample.
+
+        \throw std::invalid_argument Occurs when the kernel is empty
+    */
+    StreamConvolver(const std::vector<double> &kernel, uint32_t block_size = 0);
+
+    /*! \return the number of new input samples consumed by each block */
+    uint32_t BlockSize() const;
+
+    /*! \return the length of the transform applied to each block */
+    uint32_t FFTSize() const;
+
+    /*!
+        \brief Feeds samples to the stream
+        \param [in] samples the next input samples, of any length
+        \return the next output samples, a whole number of blocks
+    */
+    std::vector<double> Process(const std::vector<double> &samples);
+
+    /*!
+        \brief Ends the stream, then resets the convolver so it can start a new one
+        \return the remaining outputs: the held back samples and the kernel_size - 1 tail samples.
+        Empty if no samples were fed, since the convolution of an empty stream is empty.
+        Over a whole stream of n > 0 samples, Process and Flush emit n + kernel_size - 1 outputs.
+    */
+    std::vector<double> Flush();
+
+    /*! Discards held back samples and history, starting a new stream */
+    void Reset();
+};
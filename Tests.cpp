@@ -0,0 +1,908 @@
+/*
+    Checks of the library against slow reference implementations.
+
+    Usage: tests [name]
+
+    Runs the named test, or every test. Each failed check is printed with its line,
+    and the exit status is non-zero if any check failed. CMake registers every test with ctest.
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MappedPolynomial.h"
+#include "ModPolynomial.h"
+#include "Polynomial.h"
+#include "StreamConvolver.h"
+#include "Util.h"
+
+static int failures = 0;
+
+static void Check(bool ok, const char *expr, int line) {
+    if (!ok) {
+        std::cerr << "Tests.cpp:" << line << ": check failed: " << expr << std::endl;
+        failures++;
+    }
+}
+
+#define CHECK(cond) Check((cond), #cond, __LINE__)
+
+static std::mt19937_64 rng(12345);
+
+static std::vector<double> RandomInts(size_t n, int64_t lo, int64_t hi) {
+    std::uniform_int_distribution<int64_t> d(lo, hi);
+    std::vector<double> c(n);
+    for (double &x : c) {
+        x = static_cast<double>(d(rng));
+    }
+    return c;
+}
+
+static std::vector<double> RandomReals(size_t n, double lo, double hi) {
+    std::uniform_real_distribution<double> d(lo, hi);
+    std::vector<double> c(n);
+    for (double &x : c) {
+        x = d(rng);
+    }
+    return c;
+}
+
+static std::vector<double> Coeffs(const Polynomial &p) {
+    std::vector<double> c(p.Degree() + 1);
+    for (size_t i = 0; i < c.size(); i++) {
+        c[i] = p[i];
+    }
+    return c;
+}
+
+/* Schoolbook product */
+static std::vector<double> NaiveMult(const std::vector<double> &a, const std::vector<double> &b) {
+    std::vector<double> r(a.size() + b.size() - 1, 0);
+    for (size_t i = 0; i < a.size(); i++) {
+        for (size_t j = 0; j < b.size(); j++) {
+            r[i + j] += a[i] * b[j];
+        }
+    }
+    return r;
+}
+
+/* Largest absolute difference, counting missing coefficients as 0 */
+static double MaxError(const std::vector<double> &a, const std::vector<double> &b) {
+    double err = 0;
+    for (size_t i = 0; i < std::max(a.size(), b.size()); i++) {
+        double x = i < a.size() ? a[i] : 0;
+        double y = i < b.size() ? b[i] : 0;
+        err = std::max(err, std::abs(x - y));
+    }
+    return err;
+}
+
+/* DFT by the definition, in long double */
+static std::vector<cd> NaiveDFT(const std::vector<cd> &a) {
+    const size_t N = a.size();
+    const long double tau = 6.283185307179586476925286766559L;
+    std::vector<long double> c(N), sn(N);
+    for (size_t j = 0; j < N; j++) {
+        c[j] = std::cos(-tau * j / N);
+        sn[j] = std::sin(-tau * j / N);
+    }
+    std::vector<cd> r(N);
+    for (size_t k = 0; k < N; k++) {
+        long double re = 0, im = 0;
+        for (size_t j = 0; j < N; j++) {
+            size_t jk = (j * k) % N;
+            re += a[j].real() * c[jk] - a[j].imag() * sn[jk];
+            im += a[j].real() * sn[jk] + a[j].imag() * c[jk];
+        }
+        r[k] = cd(static_cast<double>(re), static_cast<double>(im));
+    }
+    return r;
+}
+
+static std::vector<cd> RandomComplex(size_t n) {
+    std::vector<double> re = RandomReals(n, -1, 1);
+    std::vector<double> im = RandomReals(n, -1, 1);
+    std::vector<cd> a(n);
+    for (size_t i = 0; i < n; i++) {
+        a[i] = cd(re[i], im[i]);
+    }
+    return a;
+}
+
+static double MaxError(const std::vector<cd> &a, const std::vector<cd> &b) {
+    double err = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        err = std::max(err, std::abs(a[i] - b[i]));
+    }
+    return err;
+}
+
+/* Whether every extra thread is free, i.e. no finished task kept its reservation */
+static bool AllThreadsFree() {
+    size_t taken = 0;
+    while (ReserveThread()) {
+        taken++;
+    }
+    for (size_t i = 0; i < taken; i++) {
+        ReleaseThread();
+    }
+    return taken + 1 == GetThreadCount();
+}
+
+/*
+    Polynomials mod MOD as plain coefficient vectors without leading zeros,
+    for the quadratic Euclidean algorithm the half-GCD is checked against
+*/
+typedef std::vector<uint64_t> ModCoeffs;
+
+static void Trim(ModCoeffs &a) {
+    while (!a.empty() && a.back() == 0) {
+        a.pop_back();
+    }
+}
+
+static ModCoeffs RandomMod(size_t n) {
+    std::uniform_int_distribution<uint64_t> d(0, MOD - 1);
+    ModCoeffs a(n);
+    for (uint64_t &x : a) {
+        x = d(rng);
+    }
+    a.back() = std::max<uint64_t>(a.back(), 1);
+    return a;
+}
+
+static ModCoeffs NaiveModMult(const ModCoeffs &a, const ModCoeffs &b) {
+    ModCoeffs r(a.size() + b.size() - 1, 0);
+    for (size_t i = 0; i < a.size(); i++) {
+        for (size_t j = 0; j < b.size(); j++) {
+            r[i + j] = (r[i + j] + a[i] * b[j]) % MOD;
+        }
+    }
+    Trim(r);
+    return r;
+}
+
+static ModCoeffs NaiveModRem(ModCoeffs a, const ModCoeffs &b) {
+    uint64_t inv = mod_inverse(static_cast<uint32_t>(b.back()));
+    while (a.size() >= b.size()) {
+        uint64_t c = a.back() * inv % MOD;
+        size_t shift = a.size() - b.size();
+        for (size_t i = 0; i < b.size(); i++) {
+            a[shift + i] = (a[shift + i] + MOD - c * b[i] % MOD) % MOD;
+        }
+        Trim(a);
+    }
+    return a;
+}
+
+static ModCoeffs NaiveModGcd(ModCoeffs a, ModCoeffs b) {
+    while (!b.empty()) {
+        ModCoeffs r = NaiveModRem(a, b);
+        a = std::move(b);
+        b = std::move(r);
+    }
+    if (!a.empty()) {
+        uint64_t inv = mod_inverse(static_cast<uint32_t>(a.back()));
+        for (uint64_t &x : a) {
+            x = x * inv % MOD;
+        }
+    }
+    return a;
+}
+
+/* res(a, b) = (-1)^(deg a deg b) lc(b)^(deg a - deg r) res(b, r) for r = a mod b */
+static uint64_t NaiveModResultant(const ModCoeffs &a, const ModCoeffs &b) {
+    if (a.empty() || b.empty()) {
+        return 0;
+    }
+    size_t da = a.size() - 1;
+    size_t db = b.size() - 1;
+    if (db == 0) {
+        return mod_pow(static_cast<uint32_t>(b[0]), da);
+    }
+    ModCoeffs r = NaiveModRem(a, b);
+    if (r.empty()) {
+        return 0;
+    }
+    uint64_t res = mod_pow(static_cast<uint32_t>(b.back()), da - (r.size() - 1)) * NaiveModResultant(b, r) % MOD;
+    return (da * db) % 2 ? (MOD - res) % MOD : res;
+}
+
+static ModPolynomial ToMod(const ModCoeffs &a) {
+    return ModPolynomial(std::vector<int64_t>(a.begin(), a.end()));
+}
+
+static void TestFFT() {
+    // Every radix and their mixes, and primes and other lengths that need Bluestein's algorithm
+    std::vector<size_t> lengths;
+    for (size_t n = 1; n <= 64; n++) {
+        lengths.push_back(n);
+    }
+    for (size_t n : { 97, 210, 243, 343, 625, 1000, 1024, 1031, 2310, 4096, 4099 }) {
+        lengths.push_back(n);
+    }
+    for (size_t n : lengths) {
+        std::vector<cd> a = RandomComplex(n);
+        std::vector<cd> A = FFT(a);
+        CHECK(A.size() == n);
+        CHECK(MaxError(A, NaiveDFT(a)) < 1e-13 * std::sqrt(static_cast<double>(n)) * std::log2(n + 1.0));
+        CHECK(MaxError(InverseFFT(A), a) < 1e-14 * std::log2(n + 1.0));
+
+        // The real overload agrees with the complex transform
+        std::vector<double> re = RandomReals(n, -1, 1);
+        CHECK(MaxError(FFT(re), FFT(std::vector<cd>(re.begin(), re.end()))) == 0);
+    }
+
+    // Past the cached twiddle tables, where the factors are computed on use: 
+    // the transform of a unit impulse at 1 is the factors themselves
+    const size_t N = 3 << 19;
+    std::vector<cd> impulse(N, 0);
+    impulse[1] = 1;
+    std::vector<cd> w = FFT(impulse);
+    double err = 0;
+    for (size_t k = 0; k < N; k += 97) {
+        long double theta = -6.283185307179586476925286766559L * k / N;
+        err = std::max(err, std::abs(w[k] - cd(static_cast<double>(std::cos(theta)), static_cast<double>(std::sin(theta)))));
+    }
+    CHECK(err < 1e-15);
+    std::vector<cd> a = RandomComplex(N);
+    CHECK(MaxError(InverseFFT(FFT(a)), a) < 1e-13);
+
+    // smooth_round picks a 7-smooth length no longer than the next power of 2
+    for (uint32_t n = 1; n <= 5000; n++) {
+        uint32_t m = smooth_round(n);
+        CHECK(m >= n && m <= pow2_round(n));
+        for (uint32_t p : { 2, 3, 5, 7 }) {
+            while (m % p == 0) {
+                m /= p;
+            }
+        }
+        CHECK(m == 1);
+    }
+    CHECK(smooth_round(1025) < 2048);
+}
+
+/* |p(z)| relative to sum_k |p_k| |z|^k, the size of the rounding error in evaluating p at z */
+static double RootResidual(const Polynomial &p, cd z) {
+    cd value = 0;
+    double scale = 0;
+    for (size_t k = p.Degree() + 1; k > 0; k--) {
+        value = value * z + p[k - 1];
+        scale = scale * std::abs(z) + std::abs(p[k - 1]);
+    }
+    return std::abs(value) / scale;
+}
+
+static double MaxResidual(const Polynomial &p, const std::vector<cd> &roots) {
+    double err = 0;
+    for (cd z : roots) {
+        err = std::max(err, RootResidual(p, z));
+    }
+    return err;
+}
+
+static void TestPolyRoots() {
+    // Random polynomials, the last past the degree at which a sweep is split across threads
+    std::vector<Polynomial> polys;
+    for (size_t len : { 2, 3, 21, 101, 601 }) {
+        polys.push_back(Polynomial(RandomReals(len, -1, 1)));
+    }
+    SetThreadCount(4);
+    for (const Polynomial &p : polys) {
+        std::vector<cd> roots = p.PolyRoots();
+        CHECK(roots.size() == p.Degree());
+        CHECK(MaxResidual(p, roots) < 1e-13);
+    }
+    CHECK(AllThreadsFree());
+
+    // x = 0 is returned exactly, once per vanishing low coefficient
+    Polynomial zeros({ 0, 0, 0, -2, -1, 1 });
+    std::vector<cd> roots = zeros.PolyRoots();
+    CHECK(roots.size() == 5);
+    CHECK(std::count(roots.begin(), roots.end(), cd(0, 0)) == 3);
+    CHECK(MaxResidual(zeros, roots) < 1e-15);
+
+    // A triple root at 1 only converges to about the cube root of epsilon, but the residual stays small
+    Polynomial triple({ -2, 5, -3, -1, 1 });
+    roots = triple.PolyRoots();
+    CHECK(roots.size() == 4);
+    CHECK(std::count_if(roots.begin(), roots.end(), [](cd z) { return std::abs(z - 1.0) < 1e-4; }) == 3);
+    CHECK(std::count_if(roots.begin(), roots.end(), [](cd z) { return std::abs(z + 2.0) < 1e-12; }) == 1);
+    CHECK(MaxResidual(triple, roots) < 1e-14);
+
+    // Constants, including zero, and zero leading coefficients
+    CHECK(Polynomial({ 5 }).PolyRoots().empty());
+    CHECK(Polynomial({ 0 }).PolyRoots().empty());
+    CHECK(Polynomial({ 0, 0, 0 }).PolyRoots().empty());
+    roots = Polynomial({ -3, 1, 0, 0 }).PolyRoots();
+    CHECK(roots.size() == 1 && std::abs(roots[0] - 3.0) < 1e-15);
+
+    // The batched overload matches the single one, which only splits its own sweeps
+    polys.push_back(zeros);
+    polys.push_back(triple);
+    polys.push_back(Polynomial({ 0 }));
+    std::vector<std::vector<cd>> batch = Polynomial::PolyRoots(polys);
+    CHECK(AllThreadsFree());
+    CHECK(batch.size() == polys.size());
+    for (size_t i = 0; i < polys.size(); i++) {
+        CHECK(batch[i] == polys[i].PolyRoots());
+    }
+    SetThreadCount(0);
+}
+
+static void TestNewtonsMethod() {
+    // (x - 1)(x - 2)(x - 3), with guesses near each root, between two, and far out
+    Polynomial p({ -6, 11, -6, 1 });
+    std::vector<double> guesses = { 0.5, 1.9, 3.4, 2.5, 10, -5 };
+    std::vector<double> roots = p.NewtonsMethod(guesses, 1e-12);
+    CHECK(roots.size() == guesses.size());
+    for (size_t i = 0; i < roots.size(); i++) {
+        CHECK(roots[i] == p.NewtonsMethod(guesses[i], 1e-12));
+        CHECK(std::abs(roots[i] - std::round(roots[i])) < 1e-12 && std::round(roots[i]) >= 1 && std::round(roots[i]) <= 3);
+    }
+    CHECK(std::abs(roots[0] - 1) < 1e-12 && std::abs(roots[1] - 2) < 1e-12 && std::abs(roots[2] - 3) < 1e-12);
+
+    // Enough guesses to split across threads, each still matching the single start
+    Polynomial q(RandomReals(30, -1, 1));
+    guesses = RandomReals(1000, -2, 2);
+    SetThreadCount(4);
+    roots = q.NewtonsMethod(guesses);
+    CHECK(AllThreadsFree());
+    SetThreadCount(0);
+    for (size_t i = 0; i < roots.size(); i++) {
+        CHECK(roots[i] == q.NewtonsMethod(guesses[i]));
+    }
+
+    // No iterations leave the guesses as they are, and no guesses give no roots
+    CHECK(p.NewtonsMethod(guesses, 1e-6, 0) == guesses);
+    CHECK(p.NewtonsMethod(std::vector<double>()).empty());
+}
+
+/* The product of the factors, one schoolbook multiplication at a time */
+static std::vector<double> NaiveProduct(const std::vector<std::vector<double>> &factors) {
+    std::vector<double> r(1, 1);
+    for (const std::vector<double> &f : factors) {
+        r = NaiveMult(r, f);
+    }
+    return r;
+}
+
+static void TestPolyProduct() {
+    // Eight factors of 40 terms: the first level multiplies by FFT, and the later ones reuse
+    // the spectra of their children. The integer products stay well within roundError.
+    for (size_t count : { 8, 7, 2, 1 }) {
+        std::vector<std::vector<double>> factors;
+        std::vector<Polynomial> polys;
+        for (size_t i = 0; i < count; i++) {
+            factors.push_back(RandomInts(40, -1, 1));
+            factors.back().back() = 1;
+            polys.push_back(Polynomial(factors.back()));
+        }
+        SetThreadCount(4);
+        CHECK(Coeffs(Polynomial::PolyProduct(polys)) == NaiveProduct(factors));
+        CHECK(AllThreadsFree());
+        SetThreadCount(0);
+    }
+
+    // Factors of uneven degrees are paired by size, with an odd one carried up a level
+    std::vector<std::vector<double>> factors;
+    std::vector<Polynomial> polys;
+    for (size_t len : { 3, 70, 1, 35, 200, 2, 90, 41, 5 }) {
+        factors.push_back(RandomReals(len, -1, 1));
+        polys.push_back(Polynomial(factors.back()));
+    }
+    std::vector<double> expected = NaiveProduct(factors);
+    double norm = std::abs(*std::max_element(expected.begin(), expected.end(), 
+                                              [](double x, double y) { return std::abs(x) < std::abs(y); }));
+    CHECK(MaxError(Coeffs(Polynomial::PolyProduct(polys)), expected) < 1e-13 * norm);
+    CHECK(Coeffs(Polynomial::PolyProduct({})) == std::vector<double>({ 1 }));
+
+    // An odd number of roots leaves a linear leaf beside the quadratic ones
+    for (size_t count : { 301, 256, 1 }) {
+        std::vector<double> roots = RandomReals(count, -1, 1);
+        factors.clear();
+        for (double r : roots) {
+            factors.push_back({ -r, 1 });
+        }
+        expected = NaiveProduct(factors);
+        norm = std::abs(*std::max_element(expected.begin(), expected.end(), 
+                                          [](double x, double y) { return std::abs(x) < std::abs(y); }));
+        std::vector<double> c = Coeffs(Polynomial::PolyFromRoots(roots));
+        CHECK(c.size() == count + 1);
+        CHECK(MaxError(c, expected) < 1e-13 * norm);
+    }
+    CHECK(Coeffs(Polynomial::PolyFromRoots({ 2, -3 })) == std::vector<double>({ -6, 1, 1 }));
+    CHECK(Coeffs(Polynomial::PolyFromRoots({})) == std::vector<double>({ 1 }));
+}
+
+static void TestPolyGcd() {
+    for (size_t n : { 10, 100, 400 }) {
+        ModCoeffs g = RandomMod(n / 3 + 1);
+        ModCoeffs a = NaiveModMult(g, RandomMod(n));
+        ModCoeffs b = NaiveModMult(g, RandomMod(n - n / 4));
+        ModCoeffs expected = NaiveModGcd(a, b);
+        CHECK(expected.size() >= g.size());
+        CHECK(ModPolynomial::PolyGcd(ToMod(a), ToMod(b)) == ToMod(expected));
+        CHECK(ModPolynomial::PolyGcd(ToMod(b), ToMod(a)) == ToMod(expected));
+    }
+
+    // Coprime inputs, and a zero input
+    ModCoeffs a = RandomMod(300);
+    ModCoeffs b = RandomMod(200);
+    CHECK(ModPolynomial::PolyGcd(ToMod(a), ToMod(b)) == ToMod(NaiveModGcd(a, b)));
+    CHECK(ModPolynomial::PolyGcd(ToMod(a), ModPolynomial({ 0 })) == ToMod(NaiveModGcd(a, {})));
+}
+
+static void TestPolyExtGcd() {
+    for (size_t n : { 10, 100, 400 }) {
+        ModCoeffs g = RandomMod(n / 5 + 1);
+        ModPolynomial a = ToMod(NaiveModMult(g, RandomMod(n)));
+        ModPolynomial b = ToMod(NaiveModMult(g, RandomMod(n / 2)));
+        ModPolynomial::ExtGcdResult r = ModPolynomial::PolyExtGcd(a, b);
+
+        ModCoeffs ac(a.Degree() + 1), bc(b.Degree() + 1);
+        for (size_t i = 0; i < ac.size(); i++) {
+            ac[i] = a[i];
+        }
+        for (size_t i = 0; i < bc.size(); i++) {
+            bc[i] = b[i];
+        }
+        CHECK(r.gcd == ToMod(NaiveModGcd(ac, bc)));
+        CHECK(r.s * a + r.t * b == r.gcd);
+        CHECK(r.s.Degree() < b.Degree() - r.gcd.Degree());
+        CHECK(r.t.Degree() < a.Degree() - r.gcd.Degree());
+    }
+}
+
+static void TestPolyResultant() {
+    // res(x - 2, x - 5) = 2 - 5
+    CHECK(ModPolynomial::PolyResultant(ModPolynomial({ -2, 1 }), ModPolynomial({ -5, 1 })) == MOD - 3);
+
+    for (size_t n : { 10, 100, 300 }) {
+        ModCoeffs a = RandomMod(n);
+        ModCoeffs b = RandomMod(n - n / 3);
+        CHECK(ModPolynomial::PolyResultant(ToMod(a), ToMod(b)) == NaiveModResultant(a, b));
+        CHECK(ModPolynomial::PolyResultant(ToMod(b), ToMod(a)) == NaiveModResultant(b, a));
+
+        // A common factor makes the resultant vanish
+        ModCoeffs g = RandomMod(3);
+        CHECK(ModPolynomial::PolyResultant(ToMod(NaiveModMult(a, g)), ToMod(NaiveModMult(b, g))) == 0);
+    }
+}
+
+/* C(n, k), exact while it fits in 53 bits */
+static double Binomial(uint64_t n, uint64_t k) {
+    double r = 1;
+    for (uint64_t i = 1; i <= k; i++) {
+        r = r * (n - k + i) / i;
+    }
+    return r;
+}
+
+/* Largest error relative to the size of each expected coefficient */
+static double MaxRelativeError(const std::vector<double> &a, const std::vector<double> &b) {
+    double err = 0;
+    for (size_t i = 0; i < std::max(a.size(), b.size()); i++) {
+        double x = i < a.size() ? a[i] : 0;
+        double y = i < b.size() ? b[i] : 0;
+        err = std::max(err, std::abs(x - y) / std::max(1.0, std::abs(y)));
+    }
+    return err;
+}
+
+static void TestPolyPow() {
+    // (1 + x)^k mod x^n, with n past the end of the full power
+    for (uint64_t k : { 20, 30, 31, 50 }) {
+        for (uint32_t n : { 10, 31, 40, 60 }) {
+            std::vector<double> expected(std::min<uint64_t>(n, k + 1));
+            for (size_t j = 0; j < expected.size(); j++) {
+                expected[j] = Binomial(k, j);
+            }
+            CHECK(Coeffs(Polynomial::PolyPow(Polynomial({ 1, 1 }), k, n)) == expected);
+        }
+    }
+
+    // (1 + x)^200 overflows 53 bits, but must stay accurate relative to its largest coefficient
+    for (uint32_t n : { 201, 300 }) {
+        std::vector<double> c = Coeffs(Polynomial::PolyPow(Polynomial({ 1, 2, 1 }), 100, n));
+        std::vector<double> expected(201);
+        for (size_t j = 0; j <= 200; j++) {
+            expected[j] = Binomial(200, j);
+        }
+        CHECK(c.size() == 201);
+        CHECK(MaxError(c, expected) < 1e-12 * Binomial(200, 100));
+    }
+
+    // Powers of x: (x^2 + x^3)^5 = x^10 (1 + x)^5
+    CHECK(Coeffs(Polynomial::PolyPow(Polynomial({ 0, 0, 1, 1 }), 5, 13)) == std::vector<double>({ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 5, 10 }));
+    CHECK(Coeffs(Polynomial::PolyPow(Polynomial({ 0, 0, 1, 1 }), 5, 10)) == std::vector<double>({ 0 }));
+
+    // Non-integer coefficients: (1/2 + x/2)^30 by powering, and (1 + x/k)^k by exp/log
+    std::vector<double> half(31);
+    for (size_t j = 0; j <= 30; j++) {
+        half[j] = Binomial(30, j) / (1 << 30);
+    }
+    CHECK(MaxError(Coeffs(Polynomial::PolyPow(Polynomial({ 0.5, 0.5 }), 30, 100)), half) < 1e-12);
+
+    const uint64_t k = 1000000;
+    std::vector<double> e(20);
+    for (size_t j = 0; j < e.size(); j++) {
+        e[j] = Binomial(k, j) / std::pow(static_cast<double>(k), static_cast<double>(j));
+    }
+    CHECK(MaxRelativeError(Coeffs(Polynomial::PolyPow(Polynomial({ 1, 1.0 / k }), k, 20)), e) < 1e-9);
+
+    CHECK(Coeffs(Polynomial::PolyPow(Polynomial({ 3, 1 }), 4, 0)) == std::vector<double>({ 0 }));
+    CHECK(Coeffs(Polynomial::PolyPow(Polynomial({ 3, 1 }), 0, 5)) == std::vector<double>({ 1 }));
+}
+
+/* f(g) mod x^n by Horner's method with schoolbook products */
+static std::vector<double> NaiveCompose(const std::vector<double> &f, const std::vector<double> &g, size_t n) {
+    std::vector<double> r(1, f.back());
+    for (size_t i = f.size() - 1; i > 0; i--) {
+        std::vector<double> t = NaiveMult(r, g);
+        t.resize(std::min(t.size(), n));
+        t[0] += f[i - 1];
+        r = t;
+    }
+    return r;
+}
+
+static void TestPolyCompose() {
+    // Powers of these g have coefficients far larger than the result's low coefficients
+    for (double g1 : { 0.018, 0.5 }) {
+        for (bool integral : { false, true }) {
+            std::vector<double> f = integral ? RandomInts(200, -10, 10) : RandomReals(200, -0.5, 0.5);
+            std::vector<double> g = RandomReals(50, integral ? -1 : -0.5, integral ? 1 : 0.5);
+            g[0] = 0;
+            g[1] = g1;
+            std::vector<double> c = Coeffs(Polynomial::PolyCompose(Polynomial(f), Polynomial(g), 400));
+            CHECK(c.size() == 400);
+            CHECK(std::all_of(c.begin(), c.end(), [](double x) { return std::isfinite(x); }));
+
+            // [x^0] f(g) = f(g(0)) and [x^1] f(g) = f'(g(0)) g_1
+            CHECK(c[0] == f[0]);
+            CHECK(std::abs(c[1] - f[1] * g1) < 1e-15);
+
+            std::vector<double> expected = NaiveCompose(f, g, 40);
+            c.resize(40);
+            CHECK(MaxRelativeError(c, expected) < 1e-9);
+        }
+    }
+
+    // g(0) != 0 needs every term of f
+    std::vector<double> f = RandomReals(100, -1, 1);
+    std::vector<double> g = RandomReals(20, -0.5, 0.5);
+    std::vector<double> c = Coeffs(Polynomial::PolyCompose(Polynomial(f), Polynomial(g), 50));
+    double fg0 = 0;
+    double dfg0 = 0;
+    for (size_t i = f.size(); i > 0; i--) {
+        dfg0 = dfg0 * g[0] + fg0;
+        fg0 = fg0 * g[0] + f[i - 1];
+    }
+    CHECK(std::abs(c[0] - fg0) < 1e-12);
+    CHECK(std::abs(c[1] - dfg0 * g[1]) < 1e-12);
+    CHECK(MaxRelativeError(c, NaiveCompose(f, g, 50)) < 1e-9);
+
+    // Short compositions are computed in full
+    CHECK(Coeffs(Polynomial::PolyCompose(Polynomial({ 1, 2, 3 }), Polynomial({ 1, 1 }), 10)) == std::vector<double>({ 6, 8, 3 }));
+    CHECK(Coeffs(Polynomial::PolyCompose(Polynomial({ 1, 2, 3 }), Polynomial({ 0, 0, 1 }), 3)) == std::vector<double>({ 1, 0, 2 }));
+    CHECK(Coeffs(Polynomial::PolyCompose(Polynomial({ 1, 2, 3 }), Polynomial({ 5, 1 }), 0)) == std::vector<double>({ 0 }));
+
+    // Integer compositions long enough for FFT products are exact, when g needs no scaling
+    std::vector<double> fi = RandomInts(11, -3, 3);
+    std::vector<double> gi(41, 0);
+    gi[0] = 3;
+    gi[1] = 1;
+    gi[40] = -1;
+    std::vector<double> ci = Coeffs(Polynomial::PolyCompose(Polynomial(fi), Polynomial(gi), 200));
+    ci.resize(200);
+    CHECK(ci == NaiveCompose(fi, gi, 200));
+
+    // (10^3 x)^300 does not fit in a double
+    std::vector<double> big(301, 0);
+    big[300] = 1;
+    bool threw = false;
+    try {
+        Polynomial::PolyCompose(Polynomial(big), Polynomial({ 0, 1000 }), 301);
+    }
+    catch (const std::overflow_error &) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // Powers of a long g fill every term, which takes the baby-step giant-step sums. This g needs 
+    // no scaling, so every coefficient is accurate.
+    for (size_t v : { 0, 1, 3 }) {
+        std::vector<double> f = RandomReals(400, -1, 1);
+        std::vector<double> g = RandomReals(400, -1e-3, 1e-3);
+        std::fill(g.begin(), g.begin() + v, 0);
+        g[v] = 0.5;
+        std::vector<double> c = Coeffs(Polynomial::PolyCompose(Polynomial(f), Polynomial(g), 400));
+        CHECK(c.size() == 400);
+        CHECK(v == 0 || c[0] == f[0]);
+        CHECK(MaxRelativeError(c, NaiveCompose(f, g, 400)) < 1e-13);
+    }
+
+    // Long enough for the recursion, or the sums, to split across threads, which must not change the result
+    std::vector<double> outer = RandomReals(3000, -1, 1);
+    std::vector<double> coeffs = RandomReals(3000, -1e-4, 1e-4);
+    coeffs[0] = 0;
+    for (const Polynomial &inner : { Polynomial({ 0, 0.5, 0.25 }), Polynomial(coeffs) }) {
+        SetThreadCount(4);
+        Polynomial threaded = Polynomial::PolyCompose(Polynomial(outer), inner, 3000);
+        CHECK(AllThreadsFree());
+        SetThreadCount(1);
+        CHECK(Coeffs(Polynomial::PolyCompose(Polynomial(outer), inner, 3000)) == Coeffs(threaded));
+        SetThreadCount(0);
+    }
+}
+
+/* p(ax + c), by repeated synthetic division for p(x + c), then scaling coefficient k by a^k */
+static std::vector<double> NaiveAffine(std::vector<double> p, double a, double c) {
+    for (size_t i = 0; i + 1 < p.size(); i++) {
+        for (size_t j = p.size() - 1; j > i; j--) {
+            p[j - 1] += c * p[j];
+        }
+    }
+    double ak = 1;
+    for (double &x : p) {
+        x *= ak;
+        ak *= a;
+    }
+    while (p.size() > 1 && p.back() == 0) {
+        p.pop_back();
+    }
+    return p;
+}
+
+/* Checks PolyAffine against NaiveAffine, within the normwise error the documentation promises */
+static bool AffineWithinBound(const std::vector<double> &p, double a, double c, const std::vector<double> &result) {
+    double r = std::abs(c) + std::min(std::abs(a), std::max(1.0, std::abs(c)));
+    double growth = std::max(1.0, std::abs(a) / std::max(1.0, std::abs(c)));
+    double bound = 0;
+    for (size_t i = p.size(); i > 0; i--) {
+        bound = bound * r + std::abs(p[i - 1]);
+    }
+    std::vector<double> expected = NaiveAffine(p, a, c);
+    double scale = 1e-14 * bound;
+    for (size_t k = 0; k < p.size(); k++) {
+        double x = k < result.size() ? result[k] : 0;
+        double y = k < expected.size() ? expected[k] : 0;
+        if (!(std::abs(x - y) <= scale)) {
+            return false;
+        }
+        scale *= growth;
+    }
+    return result.size() <= p.size();
+}
+
+static void TestPolyShift() {
+    // Integer shifts are exact while the coefficients stay below 2^53, here up to 2^50
+    std::vector<double> p = RandomInts(51, -1, 1);
+    CHECK(Coeffs(Polynomial::PolyShift(Polynomial(p), 1)) == NaiveAffine(p, 1, 1));
+    CHECK(Coeffs(Polynomial::PolyShift(Polynomial(p), -1)) == NaiveAffine(p, 1, -1));
+    p = RandomInts(21, -10, 10);
+    CHECK(Coeffs(Polynomial::PolyAffine(Polynomial(p), 2, -1)) == NaiveAffine(p, 2, -1));
+    CHECK(Coeffs(Polynomial::PolyAffine(Polynomial(p), -3, 0)) == NaiveAffine(p, -3, 0));
+    CHECK(Coeffs(Polynomial::PolyShift(Polynomial({ 1, 2, 1 }), -1)) == std::vector<double>({ 0, 0, 1 }));
+    CHECK(Coeffs(Polynomial::PolyShift(Polynomial({ 5 }), 3)) == std::vector<double>({ 5 }));
+    CHECK(Coeffs(Polynomial::PolyShift(Polynomial({ 0 }), 3)) == std::vector<double>({ 0 }));
+
+    // Long enough for FFT products, with errors within the documented bound. The shift by 1 loses the
+    // top coefficients entirely, but stays within its far larger bound.
+    p = RandomReals(300, -1, 1);
+    for (double c : { 0.05, -0.5, 1.0 }) {
+        CHECK(AffineWithinBound(p, 1, c, Coeffs(Polynomial::PolyShift(Polynomial(p), c))));
+    }
+    for (double a : { 0.5, -3.0 }) {
+        CHECK(AffineWithinBound(p, a, 0.25, Coeffs(Polynomial::PolyAffine(Polynomial(p), a, 0.25))));
+    }
+
+    // The batched overload matches the single one, for every degree
+    std::vector<Polynomial> polys;
+    for (size_t len : { 1, 2, 40, 300, 33, 1 }) {
+        polys.push_back(Polynomial(RandomReals(len, -1, 1)));
+    }
+    SetThreadCount(4);
+    std::vector<Polynomial> batch = Polynomial::PolyAffine(polys, 0.5, 0.25);
+    CHECK(AllThreadsFree());
+    SetThreadCount(0);
+    CHECK(batch.size() == polys.size());
+    for (size_t i = 0; i < polys.size(); i++) {
+        CHECK(Coeffs(batch[i]) == Coeffs(Polynomial::PolyAffine(polys[i], 0.5, 0.25)));
+        CHECK(AffineWithinBound(Coeffs(polys[i]), 0.5, 0.25, Coeffs(batch[i])));
+    }
+}
+
+/* Evaluates the Newton form directly, by Horner's method */
+static double NewtonEval(const std::vector<double> &coeffs, const std::vector<double> &nodes, double x) {
+    double r = coeffs.back();
+    for (size_t k = coeffs.size() - 1; k > 0; k--) {
+        r = r * (x - nodes[k - 1]) + coeffs[k - 1];
+    }
+    return r;
+}
+
+static void TestNewtonBasis() {
+    // Up to lengths that take the tree paths of both conversions. Nodes in a short interval keep 
+    // the node products, and so the monomial coefficients, small enough to convert accurately.
+    for (size_t n : { 5, 40, 100, 300 }) {
+        std::vector<double> coeffs = RandomReals(n, -1, 1);
+        std::vector<double> nodes = RandomReals(n, -0.2, 0.2);
+        Polynomial p = Polynomial::PolyFromNewton(coeffs, nodes);
+        CHECK(p.Degree() == n - 1);
+        for (double x : RandomReals(10, -0.2, 0.2)) {
+            double expected = NewtonEval(coeffs, nodes, x);
+            CHECK(std::abs(p.PolyEval(x) - expected) < 1e-9 * std::max(1.0, std::abs(expected)));
+        }
+
+        std::vector<double> back = Polynomial::PolyToNewton(p, nodes);
+        CHECK(back.size() == n);
+        CHECK(MaxError(back, coeffs) < 1e-9);
+
+        // The last node is never used, so one fewer than the number of coefficients suffices
+        nodes.pop_back();
+        CHECK(MaxError(Coeffs(Polynomial::PolyFromNewton(coeffs, nodes)), Coeffs(p)) < 1e-12);
+        CHECK(MaxError(Polynomial::PolyToNewton(p, nodes), back) < 1e-12);
+    }
+
+    // 1 + 2x + 3x(x - 1) = 1 - x + 3x^2
+    CHECK(Coeffs(Polynomial::PolyFromNewton({ 1, 2, 3 }, { 0, 1 })) == std::vector<double>({ 1, -1, 3 }));
+    CHECK(Polynomial::PolyToNewton(Polynomial({ 1, -1, 3 }), { 0, 1 }) == std::vector<double>({ 1, 2, 3 }));
+    CHECK(Polynomial::PolyToNewton(Polynomial({ 7 }), {}) == std::vector<double>({ 7 }));
+
+    // Long enough for the node tree and both conversions to split across threads,
+    // which must not change the result
+    std::vector<double> coeffs = RandomReals(5000, -1, 1);
+    std::vector<double> nodes = RandomReals(4999, -0.01, 0.01);
+    SetThreadCount(4);
+    Polynomial p = Polynomial::PolyFromNewton(coeffs, nodes);
+    std::vector<double> back = Polynomial::PolyToNewton(p, nodes);
+    CHECK(AllThreadsFree());
+    SetThreadCount(1);
+    CHECK(Coeffs(Polynomial::PolyFromNewton(coeffs, nodes)) == Coeffs(p));
+    CHECK(Polynomial::PolyToNewton(p, nodes) == back);
+    SetThreadCount(0);
+}
+
+static void TestFallingFactorial() {
+    // x(x-1)(x-2) = x^3 - 3x^2 + 2x
+    std::vector<double> cubic = Coeffs(Polynomial::PolyFromFallingFactorial({ 0, 0, 0, 1 }));
+    CHECK(cubic == std::vector<double>({ 0, 2, -3, 1 }));
+
+    // Stirling numbers stay exact in doubles up to degree 15
+    std::vector<double> b = RandomInts(16, -5, 5);
+    Polynomial p = Polynomial::PolyFromFallingFactorial(b);
+    CHECK(Polynomial::PolyToFallingFactorial(p) == b);
+    for (int x = 0; x < 16; x++) {
+        double expected = 0;
+        double falling = 1;
+        for (int k = 0; k < 16; k++) {
+            expected += b[k] * falling;
+            falling *= x - k;
+        }
+        CHECK(p.PolyEval(x) == expected);
+    }
+}
+
+static void TestStreamConvolver() {
+    std::vector<double> kernel = RandomReals(37, -1, 1);
+    StreamConvolver conv(kernel, 100);
+    CHECK(conv.BlockSize() >= 100);
+    CHECK(conv.FFTSize() == conv.BlockSize() + kernel.size() - 1);
+
+    for (int stream = 0; stream < 2; stream++) {
+        std::vector<double> input = RandomReals(5000, -1, 1);
+        std::vector<double> output;
+        std::uniform_int_distribution<size_t> chunk(0, 700);
+        for (size_t pos = 0; pos < input.size();) {
+            size_t len = std::min(chunk(rng), input.size() - pos);
+            std::vector<double> out = conv.Process(std::vector<double>(input.begin() + pos, input.begin() + pos + len));
+            CHECK(out.size() % conv.BlockSize() == 0);
+            output.insert(output.end(), out.begin(), out.end());
+            pos += len;
+        }
+        std::vector<double> tail = conv.Flush();
+        output.insert(output.end(), tail.begin(), tail.end());
+
+        // Flush starts a new stream, so the second pass must not see the first
+        std::vector<double> expected = NaiveMult(kernel, input);
+        CHECK(output.size() == expected.size());
+        CHECK(MaxError(output, expected) < 1e-9);
+    }
+
+    // An empty stream convolves to nothing, even when fed empty chunks
+    CHECK(conv.Flush().empty());
+    CHECK(conv.Process({}).empty());
+    CHECK(conv.Flush().empty());
+
+    // A single sample is followed by the kernel_size - 1 tail samples
+    CHECK(conv.Process({ 1 }).empty());
+    std::vector<double> impulse = conv.Flush();
+    CHECK(MaxError(impulse, kernel) < 1e-12);
+}
+
+static void TestPolyMultFile() {
+    const std::string p_path = "tests_p.poly";
+    const std::string q_path = "tests_q.poly";
+    const std::string out_path = "tests_pq.poly";
+
+    std::vector<double> p = RandomInts(1000, -10, 10);
+    std::vector<double> q = RandomInts(700, -10, 10);
+    MappedPolynomial::Save(p_path, p.data(), p.size());
+    MappedPolynomial::Save(q_path, q.data(), q.size());
+
+    // Block sizes that split both factors unevenly, and one larger than both
+    for (size_t block : { 64, 300, 4096 }) {
+        MappedPolynomial::PolyMultFile(p_path, q_path, out_path, block);
+        CHECK(Coeffs(Polynomial::PolyLoad(out_path)) == NaiveMult(p, q));
+    }
+
+    // Squaring reads the one factor file twice
+    MappedPolynomial::PolyMultFile(p_path, p_path, out_path, 128);
+    CHECK(Coeffs(Polynomial::PolyLoad(out_path)) == NaiveMult(p, p));
+
+    std::remove(p_path.c_str());
+    std::remove(q_path.c_str());
+    std::remove(out_path.c_str());
+}
+
+static void TestPolyMultExact() {
+    // 20 bit coefficients: plain PolyMult loses the low bits of products this size
+    for (size_t n : { 10, 3000 }) {
+        std::vector<double> a = RandomInts(n, -(1 << 20), 1 << 20);
+        std::vector<double> b = RandomInts(n + 17, -(1 << 20), 1 << 20);
+        CHECK(Coeffs(Polynomial::PolyMultExact(Polynomial(a), Polynomial(b))) == NaiveMult(a, b));
+    }
+
+    // Coefficients near 2^40, whose products approach 2^53
+    std::vector<double> a = RandomInts(5, -(int64_t(1) << 40), int64_t(1) << 40);
+    std::vector<double> b = RandomInts(5, -(1 << 10), 1 << 10);
+    CHECK(Coeffs(Polynomial::PolyMultExact(Polynomial(a), Polynomial(b))) == NaiveMult(a, b));
+}
+
+struct Test {
+    const char *name;
+    void (*run)();
+};
+
+static const Test tests[] = {
+    { "FFT", TestFFT },
+    { "PolyRoots", TestPolyRoots },
+    { "NewtonsMethod", TestNewtonsMethod },
+    { "PolyProduct", TestPolyProduct },
+    { "PolyGcd", TestPolyGcd },
+    { "PolyExtGcd", TestPolyExtGcd },
+    { "PolyResultant", TestPolyResultant },
+    { "PolyPow", TestPolyPow },
+    { "PolyCompose", TestPolyCompose },
+    { "PolyShift", TestPolyShift },
+    { "NewtonBasis", TestNewtonBasis },
+    { "FallingFactorial", TestFallingFactorial },
+    { "StreamConvolver", TestStreamConvolver },
+    { "PolyMultFile", TestPolyMultFile },
+    { "PolyMultExact", TestPolyMultExact },
+};
+
+int main(int argc, char **argv) {
+    std::string only = argc > 1 ? argv[1] : "";
+    bool found = false;
+    for (const Test &t : tests) {
+        if (only.empty() || only == t.name) {
+            found = true;
+            int before = failures;
+            t.run();
+            std::cout << t.name << (failures == before ? ": passed" : ": FAILED") << std::endl;
+        }
+    }
+    if (!found) {
+        std::cerr << "No test named " << only << std::endl;
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
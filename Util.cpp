@@ -1,5 +1,12 @@
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <complex>
+#include <future>         // std::async, std::future
+#include <memory>
+#include <mutex>
+#include <thread>         // std::thread::hardware_concurrency
+#include "Instrumentation.h"
 #include "Util.h"
 
 uint32_t pow2_round(uint32_t i) {
@@ -32,65 +39,555 @@ uint32_t bit_reverse(uint32_t v, uint32_t s) {
     return r;
 }
 
-std::vector<cd> FFT(const std::vector<double> &a) {
-    uint32_t N = a.size();
-    uint32_t l = static_cast<int> (std::ceil(std::log2(N)));
-    std::vector<cd> A(N);
+typedef std::shared_ptr<const std::vector<cd>> TwiddleTable;
 
-    for (uint32_t k = 0; k < N; k++) {
-        A[bit_reverse(k, l)] = a[k];
+/* Transforms up to this length keep their twiddle factors, in a cache of twice as many in total */
+static const uint32_t CACHED_TWIDDLES = 1 << 20;
+
+/* \f$ e^{-2 \pi i \cdot step \cdot j / N} \f$ for j < count */
+static std::vector<cd> UnitRoots(uint32_t N, uint64_t step, uint64_t count) {
+    std::vector<cd> w(count);
+    for (uint64_t j = 0; j < count; j++) {
+        double theta = -TAU * static_cast<double>(step * j) / N;
+        w[j] = cd(std::cos(theta), std::sin(theta));
     }
+    return w;
+}
 
-    uint32_t m = 1;
-    uint32_t n;
-    cd wm, w, u, t;
-    for (uint32_t s = 1; s <= l; s++) {
-        n = m; // n = m / 2
-        m <<= 1;
-        wm = cd(std::cos(-TAU / m), std::sin(-TAU / m));
-        for (uint32_t k = 0; k < N; k += m) {
-            w = cd(1, 0);
-            for (uint32_t j = 0; j <= n - 1; j++) {
-                t = w * A[k + j + n];
-                u = A[k + j];
-                A[k + j] = u + t;
-                A[k + j + n] = u - t;
-                w *= wm;
+/*
+    Twiddle factors \f$ e^{-2 \pi i k / N} \f$ computed on use, as the product of one of the first 
+    1024 factors and one of every 1024th. A transform too long for the cache holds these two 
+    short tables instead of one of its own length.
+*/
+class SplitTwiddles {
+public:
+    explicit SplitTwiddles(uint32_t N)
+        : m_lo(UnitRoots(N, 1, std::min(N, L))), m_hi(UnitRoots(N, L, (uint64_t(N) + L - 1) / L)) {}
+
+    cd operator[](size_t k) const {
+        return m_hi[k / L] * m_lo[k % L];
+    }
+
+private:
+    static const uint32_t L = 1024;
+    std::vector<cd> m_lo;
+    std::vector<cd> m_hi;
+};
+
+/*
+    The twiddle factors of a transform of length N, at most CACHED_TWIDDLES. The tables are
+    shared by all threads, so the threads of std::async find them already computed, and each 
+    thread remembers the last few it used to look them up without locking. Bluestein and the 
+    multiply paths alternate between two or three lengths.
+*/
+static TwiddleTable Twiddles(uint32_t N) {
+    // Weak references, so that a table dropped from the shared cache is freed
+    static thread_local std::vector<std::pair<uint32_t, std::weak_ptr<const std::vector<cd>>>> local;
+    static thread_local size_t local_next = 0;
+    size_t slot = local.size();
+    for (size_t i = 0; i < local.size(); i++) {
+        if (local[i].first == N) {
+            if (TwiddleTable table = local[i].second.lock()) {
+                return table;
             }
+            slot = i;
         }
     }
 
+    static std::mutex mutex;
+    static std::vector<std::pair<uint32_t, TwiddleTable>> shared;   // oldest first
+    static size_t shared_entries = 0;
+    TwiddleTable table;
+    {
+        // Threads that need a table being computed wait for it rather than compute it again
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &entry : shared) {
+            if (entry.first == N) {
+                table = entry.second;
+            }
+        }
+        if (!table) {
+            // Products of the split tables, which is much cheaper than a sine and cosine per factor
+            SplitTwiddles split(N);
+            std::vector<cd> w(N);
+            for (uint32_t k = 0; k < N; k++) {
+                w[k] = split[k];
+            }
+            table = std::make_shared<const std::vector<cd>>(std::move(w));
+            while (shared_entries + N > 2 * CACHED_TWIDDLES) {
+                shared_entries -= shared.front().first;
+                shared.erase(shared.begin());
+            }
+            shared.emplace_back(N, table);
+            shared_entries += N;
+        }
+    }
+
+    // Reuse the slot of an expired table of this length, or else a new or the oldest slot
+    if (slot == local.size() && local.size() < 4) {
+        local.emplace_back(N, table);
+    }
+    else {
+        if (slot == local.size()) {
+            slot = local_next;
+            local_next = (local_next + 1) % local.size();
+        }
+        local[slot] = std::make_pair(N, table);
+    }
+    return table;
+}
+
+/*
+    Splits N into the radices of the Stockham stages, preferring radix 4.
+    Returns an empty vector if N has a prime factor larger than 7.
+*/
+static std::vector<uint32_t> Radices(uint32_t N) {
+    std::vector<uint32_t> radices;
+    for (uint32_t p : { 7u, 5u, 3u }) {
+        while (N % p == 0) {
+            radices.push_back(p);
+            N /= p;
+        }
+    }
+    while (N % 4 == 0) {
+        radices.push_back(4);
+        N /= 4;
+    }
+    if (N == 2) {
+        radices.push_back(2);
+        N = 1;
+    }
+    if (N != 1) {
+        radices.clear();
+    }
+    return radices;
+}
+
+/*
+    Relative cost per point of a stage of each radix, used to pick transform lengths.
+    Stages of radix up to 4 are bound by memory traffic rather than arithmetic.
+*/
+static double RadixCost(uint32_t p) {
+    switch (p) {
+    case 5: return 1.3;
+    case 7: return 2.4;
+    default: return 1.0;
+    }
+}
+
+/* Estimated cost of a transform of length N, which must be 7-smooth */
+static double TransformCost(uint32_t N) {
+    double cost = 0;
+    for (uint32_t p : Radices(N)) {
+        cost += RadixCost(p);
+    }
+    return cost * N;
+}
+
+uint32_t smooth_round(uint32_t n) {
+    if (n < 2) {
+        return n;
+    }
+
+    uint64_t limit = pow2_round(n);
+    uint64_t best = limit;
+    double best_cost = TransformCost(static_cast<uint32_t>(limit));
+
+    for (uint64_t p7 = 1; p7 <= limit; p7 *= 7) {
+        for (uint64_t p5 = p7; p5 <= limit; p5 *= 5) {
+            for (uint64_t p3 = p5; p3 <= limit; p3 *= 3) {
+                uint64_t m = p3;
+                while (m < n) {
+                    m <<= 1;
+                }
+                if (m >= limit) {
+                    continue;
+                }
+
+                double cost = TransformCost(static_cast<uint32_t>(m));
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best = m;
+                }
+            }
+        }
+    }
+    return static_cast<uint32_t>(best);
+}
+
+/*
+    One decimation-in-frequency Stockham stage of radix p on sequences of length n
+    interleaved with stride s (n * s = N), reading x and writing y.
+*/
+template <class Twiddles>
+static void StockhamStage(uint32_t p, uint32_t n, uint32_t s, const Twiddles &w,
+    const cd *x, cd *y) {
+    const uint32_t m = n / p;
+
+    for (uint32_t q = 0; q < m; q++) {
+        const cd *src = x + s * q;
+        cd *dst = y + s * p * q;
+
+        if (p == 2) {
+            const cd w1 = w[q * s];
+            for (uint32_t k = 0; k < s; k++) {
+                const cd a0 = src[k], a1 = src[k + s * m];
+                dst[k] = a0 + a1;
+                dst[k + s] = (a0 - a1) * w1;
+            }
+        }
+        else if (p == 4) {
+            const cd w1 = w[q * s], w2 = w[2 * q * s], w3 = w[3 * q * s];
+            for (uint32_t k = 0; k < s; k++) {
+                const cd a0 = src[k], a1 = src[k + s * m], a2 = src[k + 2 * s * m], a3 = src[k + 3 * s * m];
+                const cd t0 = a0 + a2, t1 = a0 - a2;
+                const cd t2 = a1 + a3, t3 = a1 - a3;
+                const cd t3i(t3.imag(), -t3.real());   // -i * t3
+                dst[k] = t0 + t2;
+                dst[k + s] = (t1 + t3i) * w1;
+                dst[k + 2 * s] = (t0 - t2) * w2;
+                dst[k + 3 * s] = (t1 - t3i) * w3;
+            }
+        }
+        else if (p == 3) {
+            const double s1 = -0.86602540378443864676;    // -sin(2 pi / 3)
+            const cd w1 = w[q * s], w2 = w[2 * q * s];
+            for (uint32_t k = 0; k < s; k++) {
+                const cd a0 = src[k], a1 = src[k + s * m], a2 = src[k + 2 * s * m];
+                const cd b = a1 + a2, d = a1 - a2;
+                const cd t = a0 - 0.5 * b;
+                const cd u(-s1 * d.imag(), s1 * d.real());   // -i sin(2 pi / 3) d
+                dst[k] = a0 + b;
+                dst[k + s] = (t + u) * w1;
+                dst[k + 2 * s] = (t - u) * w2;
+            }
+        }
+        else if (p == 5) {
+            const double c1 = 0.30901699437494742410, c2 = -0.80901699437494742410;   // cos(2 pi k / 5)
+            const double s1 = 0.95105651629515357212, s2 = 0.58778525229247312917;    // sin(2 pi k / 5)
+            const cd w1 = w[q * s], w2 = w[2 * q * s], w3 = w[3 * q * s], w4 = w[4 * q * s];
+            for (uint32_t k = 0; k < s; k++) {
+                const cd a0 = src[k], a1 = src[k + s * m], a2 = src[k + 2 * s * m];
+                const cd a3 = src[k + 3 * s * m], a4 = src[k + 4 * s * m];
+                const cd b1 = a1 + a4, b2 = a2 + a3, d1 = a1 - a4, d2 = a2 - a3;
+                const cd t1 = a0 + c1 * b1 + c2 * b2, t2 = a0 + c2 * b1 + c1 * b2;
+                const cd v1 = s1 * d1 + s2 * d2, v2 = s2 * d1 - s1 * d2;
+                const cd u1(v1.imag(), -v1.real()), u2(v2.imag(), -v2.real());   // -i v
+                dst[k] = a0 + b1 + b2;
+                dst[k + s] = (t1 + u1) * w1;
+                dst[k + 2 * s] = (t2 + u2) * w2;
+                dst[k + 3 * s] = (t2 - u2) * w3;
+                dst[k + 4 * s] = (t1 - u1) * w4;
+            }
+        }
+        else {    // p == 7
+            // y_t and y_{7-t} share the cosine sums over a_j + a_{7-j} and the sine sums over a_j - a_{7-j}
+            static const double c[3] = { 0.62348980185873353053, -0.22252093395631440429, -0.90096886790241912624 };
+            static const double sn[3] = { 0.78183148246802980871, 0.97492791218182360702, 0.43388373911755812048 };
+            // (j + 1)(t + 1) mod 7 reduced to the first half turn, and the sign of its sine
+            static const uint32_t idx[3][3] = { { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 } };
+            static const double sign[3][3] = { { 1, 1, 1 }, { 1, -1, -1 }, { 1, -1, 1 } };
+            for (uint32_t k = 0; k < s; k++) {
+                const cd a0 = src[k];
+                cd b[3], d[3];
+                for (uint32_t j = 0; j < 3; j++) {
+                    const cd x = src[k + (j + 1) * s * m], y = src[k + (6 - j) * s * m];
+                    b[j] = x + y;
+                    d[j] = x - y;
+                }
+                dst[k] = a0 + b[0] + b[1] + b[2];
+                for (uint32_t t = 0; t < 3; t++) {
+                    cd re = a0, im = 0;
+                    for (uint32_t j = 0; j < 3; j++) {
+                        re += c[idx[t][j]] * b[j];
+                        im += sign[t][j] * sn[idx[t][j]] * d[j];
+                    }
+                    const cd u(im.imag(), -im.real());   // -i im
+                    dst[k + (t + 1) * s] = (re + u) * w[(t + 1) * q * s];
+                    dst[k + (6 - t) * s] = (re - u) * w[(6 - t) * q * s];
+                }
+            }
+        }
+    }
+}
+
+/* Runs the Stockham stages from x, using y as scratch. \return the buffer holding the result */
+template <class Twiddles>
+static cd *RunStages(const std::vector<uint32_t> &radices, uint32_t N, const Twiddles &w, cd *x, cd *y) {
+    uint32_t n = N, s = 1;
+    for (uint32_t p : radices) {
+        StockhamStage(p, n, s, w, x, y);
+        std::swap(x, y);
+        n /= p;
+        s *= p;
+    }
+    return x;
+}
+
+/* Forward transform of a in-place; the size of a must be 7-smooth */
+static void MixedRadixFFT(std::vector<cd> &a, const std::vector<uint32_t> &radices) {
+    const uint32_t N = static_cast<uint32_t>(a.size());
+    std::vector<cd> work(N);
+    POLY_COUNT(BYTES_ALLOCATED, N * sizeof(cd));
+
+    cd *result;
+    if (N <= CACHED_TWIDDLES) {
+        const TwiddleTable table = Twiddles(N);
+        result = RunStages(radices, N, *table, a.data(), work.data());
+    }
+    else {
+        result = RunStages(radices, N, SplitTwiddles(N), a.data(), work.data());
+    }
+
+    if (result != a.data()) {
+        a.swap(work);
+    }
+}
+
+/*
+    Forward transform of a in-place for any size, by Bluestein's algorithm:
+    \f$ jk = (j^2 + k^2 - (k - j)^2) / 2 \f$ turns the DFT into a convolution
+    with the chirp \f$ e^{\pi i k^2 / N} \f$, done with a smooth-length transform.
+*/
+static void BluesteinFFT(std::vector<cd> &a) {
+    const uint32_t N = static_cast<uint32_t>(a.size());
+    const uint32_t M = smooth_round(2 * N - 1);
+    const std::vector<uint32_t> radices = Radices(M);
+
+    std::vector<cd> chirp(N);
+    for (uint32_t k = 0; k < N; k++) {
+        // k^2 mod 2N keeps the angle small and accurate
+        uint64_t k2 = (static_cast<uint64_t>(k) * k) % (2ull * N);
+        double theta = -PI * static_cast<double>(k2) / N;
+        chirp[k] = cd(std::cos(theta), std::sin(theta));
+    }
+
+    std::vector<cd> u(M), v(M);
+    POLY_COUNT(BYTES_ALLOCATED, (N + 2 * M) * sizeof(cd));
+    for (uint32_t k = 0; k < N; k++) {
+        u[k] = a[k] * chirp[k];
+    }
+    v[0] = std::conj(chirp[0]);
+    for (uint32_t k = 1; k < N; k++) {
+        v[k] = v[M - k] = std::conj(chirp[k]);
+    }
+
+    MixedRadixFFT(u, radices);
+    MixedRadixFFT(v, radices);
+    for (uint32_t k = 0; k < M; k++) {
+        u[k] = std::conj(u[k] * v[k]);
+    }
+    MixedRadixFFT(u, radices);    // inverse via conjugation
+
+    for (uint32_t k = 0; k < N; k++) {
+        a[k] = std::conj(u[k]) * chirp[k] / static_cast<double>(M);
+    }
+}
+
+/* Forward transform of a in-place, of any size */
+static void Transform(std::vector<cd> &a) {
+    if (a.size() < 2) {
+        return;
+    }
+    POLY_TIMER(FFT_NS);
+    POLY_RECORD_FFT(a.size());
+    std::vector<uint32_t> radices = Radices(static_cast<uint32_t>(a.size()));
+    if (radices.empty()) {
+        POLY_COUNT(FFT_BLUESTEIN, 1);
+        BluesteinFFT(a);
+    }
+    else {
+        MixedRadixFFT(a, radices);
+    }
+}
+
+/* The number of radix-2 levels a transform of length N is equivalent to, for error bounds */
+static double TransformLevels(uint32_t N) {
+    std::vector<uint32_t> radices = Radices(N);
+    if (N > 1 && radices.empty()) {
+        return 3 * TransformLevels(smooth_round(2 * N - 1));
+    }
+    double levels = 0;
+    for (uint32_t p : radices) {
+        levels += std::ceil(std::log2(static_cast<double>(p)));
+    }
+    return levels;
+}
+
+double fft_error_bound(double norm_a, double norm_b, uint32_t N) {
+    const double eps = std::ldexp(1.0, -53);
+    // Twiddles come from std::cos and std::sin of -TAU * k / N, whose argument carries about 
+    // 1.5 ulp of 2 pi of error, plus an ulp for each function
+    const double beta = 16 * eps;
+    const double n = TransformLevels(N);
+
+    // (1 + x)^k - 1 rounds to 0 when evaluated directly
+    double log_growth = 3 * n * std::log1p(eps) + (3 * n + 1) * std::log1p(eps * std::sqrt(5.0)) 
+                      + 3 * n * std::log1p(beta);
+    return norm_a * norm_b * std::expm1(log_growth);
+}
+
+std::vector<cd> FFT(const std::vector<double> &a) {
+    return FFT(std::vector<cd>(a.begin(), a.end()));
+}
+
+std::vector<cd> FFT(const std::vector<cd> &a) {
+    std::vector<cd> A(a);
+    POLY_COUNT(BYTES_ALLOCATED, A.size() * sizeof(cd));
+    Transform(A);
     return A;
 }
 
 std::vector<cd> InverseFFT(const std::vector<cd> &a) {
+    const size_t N = a.size();
+    std::vector<cd> A(N);
+    POLY_COUNT(BYTES_ALLOCATED, N * sizeof(cd));
+    std::transform(a.begin(), a.end(), A.begin(), [](cd x) { return std::conj(x); });
+
+    Transform(A);
+
+    std::transform(A.begin(), A.end(), A.begin(), [N](cd x) { return std::conj(x) / static_cast<double>(N); });
+    return A;
+}
+
+uint32_t mod_pow(uint32_t a, uint64_t e) {
+    uint64_t r = 1, b = a % MOD;
+    while (e) {
+        if (e & 1) {
+            r = r * b % MOD;
+        }
+        b = b * b % MOD;
+        e >>= 1;
+    }
+    return static_cast<uint32_t>(r);
+}
+
+uint32_t mod_inverse(uint32_t a) {
+    return mod_pow(a, MOD - 2);
+}
+
+/* Shared butterfly loop of NTT and InverseNTT, with root the primitive root or its inverse */
+static std::vector<uint32_t> NTTCore(const std::vector<uint32_t> &a, uint32_t root) {
     uint32_t N = a.size();
     uint32_t l = static_cast<int> (std::ceil(std::log2(N)));
-    std::vector<cd> A(N);
+    std::vector<uint32_t> A(N);
 
     for (uint32_t k = 0; k < N; k++) {
         A[bit_reverse(k, l)] = a[k];
     }
 
+    std::vector<uint32_t> w;
     uint32_t m = 1;
     uint32_t n;
-    cd wm, w, u, t;
+    uint64_t wm, u, t;
     for (uint32_t s = 1; s <= l; s++) {
         n = m; // n = m / 2
         m <<= 1;
-        wm = cd(std::cos(TAU / m), std::sin(TAU / m));
+        wm = mod_pow(root, (MOD - 1) / m);
+        w.resize(n);
+        w[0] = 1;
+        for (uint32_t j = 1; j < n; j++) {
+            w[j] = static_cast<uint32_t>(w[j - 1] * wm % MOD);
+        }
         for (uint32_t k = 0; k < N; k += m) {
-            w = cd(1, 0);
-            for (uint32_t j = 0; j <= n - 1; j++) {
-                t = w * A[k + j + n];
+            for (uint32_t j = 0; j < n; j++) {
+                t = w[j] * static_cast<uint64_t>(A[k + j + n]) % MOD;
                 u = A[k + j];
-                A[k + j] = u + t;
-                A[k + j + n] = u - t;
-                w *= wm;
+                A[k + j] = static_cast<uint32_t>(u + t >= MOD ? u + t - MOD : u + t);
+                A[k + j + n] = static_cast<uint32_t>(u >= t ? u - t : u + MOD - t);
             }
         }
     }
 
-    std::transform(A.begin(), A.end(), A.begin(), [N](cd x) { return x / static_cast<double>(N); });
     return A;
+}
+
+std::vector<uint32_t> NTT(const std::vector<uint32_t> &a) {
+    return NTTCore(a, MOD_ROOT);
+}
+
+std::vector<uint32_t> InverseNTT(const std::vector<uint32_t> &a) {
+    std::vector<uint32_t> A = NTTCore(a, mod_inverse(MOD_ROOT));
+    uint64_t inv = mod_inverse(A.size());
+    std::transform(A.begin(), A.end(), A.begin(), [inv](uint32_t x) { return static_cast<uint32_t>(x * inv % MOD); });
+    return A;
+}
+
+static std::atomic<size_t> thread_count(0);
+
+void SetThreadCount(size_t n) {
+    thread_count = n;
+}
+
+size_t GetThreadCount() {
+    size_t n = thread_count;
+    return n ? n : std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+/* Extra threads running library tasks, across the whole process */
+static std::atomic<size_t> busy_threads(0);
+
+bool ReserveThread() {
+    size_t limit = GetThreadCount() - 1;
+    size_t busy = busy_threads;
+    while (busy < limit) {
+        if (busy_threads.compare_exchange_weak(busy, busy + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReleaseThread() {
+    busy_threads--;
+}
+
+void ParallelFor(size_t n, const std::function<void(size_t, size_t)> &f, size_t min_chunk) {
+    if (n == 0) {
+        return;
+    }
+
+    size_t threads = GetThreadCount();
+    size_t chunks = std::min(threads, std::max<size_t>(1, n / std::max<size_t>(1, min_chunk)));
+    // Every chunk but the last needs a thread of its own
+    size_t reserved = 0;
+    while (reserved + 1 < chunks && ReserveThread()) {
+        reserved++;
+    }
+    chunks = reserved + 1;
+    if (chunks == 1) {
+        f(0, n);
+        return;
+    }
+
+    size_t step = n / chunks;
+    size_t extra = n % chunks;
+    std::vector<std::future<void>> tasks;
+    size_t begin = 0, end;
+    for (size_t c = 0; c < chunks; c++) {
+        end = begin + step + (c < extra ? 1 : 0);
+        if (c + 1 == chunks) {
+            f(begin, end);
+        }
+        else {
+#ifdef POLY_INSTRUMENTATION
+            auto submitted = std::chrono::steady_clock::now();
+            tasks.push_back(std::async(std::launch::async, [&f, begin, end, submitted]() {
+                ThreadReservation reservation;
+                Instrumentation::TaskTimer timer(submitted);
+                f(begin, end);
+            }));
+#else
+            tasks.push_back(std::async(std::launch::async, [&f, begin, end]() {
+                ThreadReservation reservation;
+                f(begin, end);
+            }));
+#endif
+        }
+        begin = end;
+    }
+
+    for (std::future<void> &t : tasks) {
+        t.get();
+    }
 }
\ No newline at end of file
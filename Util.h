@@ -1,5 +1,10 @@
 #pragma once
 #include <complex>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 /*!
@@ -17,6 +22,14 @@ const double PI = 3.1415926535897932384626;
 const double TAU = 6.283185307179586476925;
 const double epsilon = 1e-6;
 
+/*! 
+    Prime modulus for exact arithmetic, \f$ 119 \cdot 2^{23} + 1 \f$.
+    Supports Number Theoretic Transforms of power of 2 lengths up to \f$ 2^{23} \f$.
+*/
+const uint32_t MOD = 998244353;
+/*! Primitive root of MOD */
+const uint32_t MOD_ROOT = 3;
+
 typedef struct PtValPair {
     double x;
     double y;
@@ -37,14 +50,108 @@ double roundError(double x);
 */
 uint32_t bit_reverse(uint32_t v, uint32_t s);
 
+/*!
+    Rounds i up to the length with only prime factors 2, 3, 5 and 7 that is
+    cheapest to transform, which is at most pow2_round(i).
+*/
+uint32_t smooth_round(uint32_t i);
+
 /*! 
-    Iterative Fast Fourier Transform 
-    Note: The size(a) should be a power of 2.
+    Fast Fourier Transform of real input, \f$ A_k = \sum_j a_j e^{-2 \pi i jk / N} \f$
+    Note: Any size is supported. Sizes whose prime factors are all at most 7 use
+    mixed-radix Stockham stages; other sizes fall back to Bluestein's algorithm,
+    which costs about three transforms of twice the length.
 */
 std::vector<cd> FFT(const std::vector<double> &a);
 
 /*! 
-    Iterative Inverse Fast Fourier Transform 
-    Note: The size(a) should be a power of 2.
+    Fast Fourier Transform of complex input
+    Note: Any size is supported; see FFT(const std::vector<double> &).
+*/
+std::vector<cd> FFT(const std::vector<cd> &a);
+
+/*! 
+    Inverse Fast Fourier Transform, including the 1/N normalization
+    Note: Any size is supported; see FFT(const std::vector<double> &).
  */
-std::vector<cd> InverseFFT(const std::vector<cd> &a);
\ No newline at end of file
+std::vector<cd> InverseFFT(const std::vector<cd> &a);
+
+/*!
+    Bound on the largest error in any coefficient of the cyclic convolution of a and b computed 
+    as InverseFFT(FFT(a) * FFT(b)) with transforms of length N, after Percival (2003):
+    \f$ \|a\|_2 \|b\|_2 \left((1+\epsilon)^{3n} (1+\epsilon\sqrt{5})^{3n+1} (1+\beta)^{3n} - 1\right) \f$
+    with \f$ \epsilon = 2^{-53} \f$ and \f$ \beta \f$ the error of a twiddle factor. A stage of radix r counts
+    as \f$ \lceil \log_2 r \rceil \f$ of the n levels, and Bluestein lengths count their three inner transforms.
+    \param [in] norm_a \f$ \|a\|_2 \f$
+    \param [in] norm_b \f$ \|b\|_2 \f$
+    \param [in] N the transform length
+*/
+double fft_error_bound(double norm_a, double norm_b, uint32_t N);
+
+/*! Computes \f$ a^e \bmod \f$ MOD */
+uint32_t mod_pow(uint32_t a, uint64_t e);
+
+/*! Computes \f$ a^{-1} \bmod \f$ MOD. a must be non-zero mod MOD. */
+uint32_t mod_inverse(uint32_t a);
+
+/*! 
+    Iterative Number Theoretic Transform over \f$ \mathbb{Z}/\mathrm{MOD} \f$
+    Note: The size(a) should be a power of 2, at most \f$ 2^{23} \f$.
+*/
+std::vector<uint32_t> NTT(const std::vector<uint32_t> &a);
+
+/*! 
+    Iterative Inverse Number Theoretic Transform over \f$ \mathbb{Z}/\mathrm{MOD} \f$
+    Note: The size(a) should be a power of 2, at most \f$ 2^{23} \f$.
+*/
+std::vector<uint32_t> InverseNTT(const std::vector<uint32_t> &a);
+
+/*!
+    Sets the number of threads the library may use at once, counting the calling thread.
+    All tasks in the process share the n - 1 extra threads; a task that finds none free runs on 
+    the thread that waits for it. 0, the default, uses std::thread::hardware_concurrency. 
+    1 runs everything on the calling thread.
+*/
+void SetThreadCount(size_t n);
+
+/*! \return the number of threads the library may use at once, at least 1 */
+size_t GetThreadCount();
+
+/*!
+    Takes one of the GetThreadCount() - 1 extra threads, if one is free.
+    \return true if a thread was taken. It must be given back with ReleaseThread.
+*/
+bool ReserveThread();
+
+/*! Gives back a thread taken with ReserveThread */
+void ReleaseThread();
+
+/*! Gives back a thread taken with ReserveThread when it goes out of scope */
+struct ThreadReservation {
+    ~ThreadReservation() { ReleaseThread(); }
+};
+
+/*!
+    Runs f(args...) like std::async: on a new thread if the task is worthwhile and ReserveThread 
+    succeeds, otherwise deferred until the future is waited on. Recursive splits through Async
+    therefore never run more than GetThreadCount() threads at once, however deep they go.
+*/
+template <class F, class... Args>
+std::future<typename std::result_of<typename std::decay<F>::type(typename std::decay<Args>::type...)>::type>
+Async(bool worthwhile, F &&f, Args &&... args) {
+    if (worthwhile && ReserveThread()) {
+        auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+        return std::async(std::launch::async, [task = std::move(task)]() mutable {
+            ThreadReservation reservation;
+            return task();
+        });
+    }
+    return std::async(std::launch::deferred, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+/*!
+    Splits [0, n) into contiguous chunks of at least min_chunk indices, one per thread it can 
+    reserve up to GetThreadCount(), and runs f(begin, end) on each chunk concurrently using std::async.
+    The last chunk runs on the calling thread.
+*/
+void ParallelFor(size_t n, const std::function<void(size_t, size_t)> &f, size_t min_chunk = 1);
\ No newline at end of file